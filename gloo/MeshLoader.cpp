@@ -4,9 +4,10 @@
 #include <algorithm>
 
 #include "gloo/utils.hpp"
+#include "gloo/MeshVertex.hpp"
 
 namespace GLOO {
-MeshData MeshLoader::Import(const std::string& filename) {
+MeshData MeshLoader::Import(const std::string& filename, bool interleaved) {
   std::string file_path = GetAssetDir() + filename;
   bool success;
   auto parsed_data = ObjParser::Parse(file_path, success);
@@ -22,6 +23,26 @@ MeshData MeshLoader::Import(const std::string& filename) {
 
   MeshData mesh_data;
   mesh_data.vertex_obj = make_unique<VertexObject>();
+  if (interleaved && parsed_data.positions) {
+    const PositionArray& positions = *parsed_data.positions;
+    bool has_normals = parsed_data.normals &&
+                       parsed_data.normals->size() == positions.size();
+    bool has_tex_coords = parsed_data.tex_coords &&
+                          parsed_data.tex_coords->size() == positions.size();
+    std::vector<MeshVertex> vertices(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+      vertices[i].position = positions[i];
+      vertices[i].normal =
+          has_normals ? (*parsed_data.normals)[i] : glm::vec3(0.0f);
+      vertices[i].tex_coord =
+          has_tex_coords ? (*parsed_data.tex_coords)[i] : glm::vec2(0.0f);
+    }
+    mesh_data.vertex_obj->UpdateCustomVertices(
+        vertices, MeshVertex::GetLayout(has_normals, has_tex_coords));
+    parsed_data.positions.reset();
+    parsed_data.normals.reset();
+    parsed_data.tex_coords.reset();
+  }
   if (parsed_data.positions) {
     mesh_data.vertex_obj->UpdatePositions(std::move(parsed_data.positions));
   }
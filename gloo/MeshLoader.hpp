@@ -7,7 +7,10 @@
 namespace GLOO {
 class MeshLoader {
  public:
-  static MeshData Import(const std::string& filename);
+  // With interleaved set, positions, normals and texture coordinates are
+  // uploaded as one MeshVertex buffer instead of one buffer per stream; the
+  // VertexObject then keeps no CPU copy of them.
+  static MeshData Import(const std::string& filename, bool interleaved = true);
 };
 }  // namespace GLOO
 
@@ -0,0 +1,36 @@
+#ifndef GLOO_MESH_VERTEX_H_
+#define GLOO_MESH_VERTEX_H_
+
+#include <cstddef>
+
+#include <glm/glm.hpp>
+
+#include "gloo/gl_wrapper/VertexLayout.hpp"
+
+namespace GLOO {
+// Interleaved vertex for imported meshes: position, normal and texture
+// coordinate share one buffer, so a vertex fetch reads one 32-byte record
+// instead of touching three separate streams.
+struct MeshVertex {
+  glm::vec3 position;
+  glm::vec3 normal;
+  glm::vec2 tex_coord;
+
+  // Streams the mesh does not have are left out of the layout, so shaders
+  // see them as missing rather than reading zeros.
+  static VertexLayout GetLayout(bool has_normals, bool has_tex_coords) {
+    VertexLayout layout(sizeof(MeshVertex));
+    layout.AddFloatAttribute(kPositionAttribute, 3,
+                             offsetof(MeshVertex, position));
+    if (has_normals)
+      layout.AddFloatAttribute(kNormalAttribute, 3,
+                               offsetof(MeshVertex, normal));
+    if (has_tex_coords)
+      layout.AddFloatAttribute(kTexCoordAttribute, 2,
+                               offsetof(MeshVertex, tex_coord));
+    return layout;
+  }
+};
+}  // namespace GLOO
+
+#endif
@@ -11,6 +11,18 @@ void SceneNode::AddChild(std::unique_ptr<SceneNode> child) {
   children_.emplace_back(std::move(child));
 }
 
+std::unique_ptr<SceneNode> SceneNode::RemoveChild(SceneNode* child) {
+  for (auto itr = children_.begin(); itr != children_.end(); ++itr) {
+    if (itr->get() == child) {
+      std::unique_ptr<SceneNode> result = std::move(*itr);
+      children_.erase(itr);
+      result->parent_ = nullptr;
+      return result;
+    }
+  }
+  return nullptr;
+}
+
 ComponentBase* SceneNode::GetComponentPtrByType(ComponentType type) const {
   if (IsActive() && component_dict_.count(type)) {
     return component_dict_.at(type).get();
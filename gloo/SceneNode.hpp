@@ -34,6 +34,9 @@ class SceneNode {
   }
 
   void AddChild(std::unique_ptr<SceneNode> child);
+  // Detaches child and hands its ownership back; returns nullptr if child is
+  // not a direct child of this node.
+  std::unique_ptr<SceneNode> RemoveChild(SceneNode* child);
 
   template <class T>
   void AddComponent(std::unique_ptr<T> component) {
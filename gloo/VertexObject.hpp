@@ -17,6 +17,12 @@ class VertexObject {
   void UpdateColors(std::unique_ptr<ColorArray> colors);
   void UpdateTexCoord(std::unique_ptr<TexCoordArray> tex_coords);
   void UpdateIndices(std::unique_ptr<IndexArray> indices);
+  // Uploads vertices in a custom layout (e.g. packed integers) as they are.
+  // No CPU copy is kept, only the vertex count. The layout is fixed by the
+  // first upload, like the buffers of the other Update* methods.
+  template <class Vertex>
+  void UpdateCustomVertices(const std::vector<Vertex>& vertices,
+                            const VertexLayout& layout);
 
   bool HasPositions() const {
     return positions_ != nullptr;
@@ -38,6 +44,14 @@ class VertexObject {
     return indices_ != nullptr;
   }
 
+  bool HasCustomVertices() const {
+    return vertex_array_->HasCustomBuffer();
+  }
+
+  size_t GetCustomVertexCount() const {
+    return custom_vertex_count_;
+  }
+
   const PositionArray& GetPositions() const {
     if (positions_ == nullptr)
       throw std::runtime_error("No position in VertexObject!");
@@ -84,8 +98,21 @@ class VertexObject {
   std::unique_ptr<ColorArray> colors_;
   std::unique_ptr<TexCoordArray> tex_coords_;
   std::unique_ptr<IndexArray> indices_;
+  size_t custom_vertex_count_ = 0;
 };
 
+template <class Vertex>
+void VertexObject::UpdateCustomVertices(const std::vector<Vertex>& vertices,
+                                        const VertexLayout& layout) {
+  if (layout.GetStride() != sizeof(Vertex))
+    throw std::runtime_error("Vertex layout stride does not match the vertex "
+                             "type!");
+  if (!vertex_array_->HasCustomBuffer())
+    vertex_array_->CreateCustomBuffer(layout);
+  vertex_array_->UpdateCustomVertices(vertices.data(), vertices.size());
+  custom_vertex_count_ = vertices.size();
+}
+
 }  // namespace GLOO
 
 #endif
@@ -6,7 +6,8 @@
 namespace GLOO {
 RenderingComponent::RenderingComponent(std::shared_ptr<VertexObject> vertex_obj)
     : vertex_obj_(std::move(vertex_obj)) {
-  if (!vertex_obj_->HasIndices() && !vertex_obj_->HasPositions()) {
+  if (!vertex_obj_->HasIndices() && !vertex_obj_->HasPositions() &&
+      !vertex_obj_->HasCustomVertices()) {
     throw std::runtime_error(
         "Cannot initialize a "
         "RenderingComponent with a VertexObject without positions!");
@@ -15,11 +16,14 @@ RenderingComponent::RenderingComponent(std::shared_ptr<VertexObject> vertex_obj)
   // We use -1 to indicate the entire range of indices/positions.
   start_index_ = -1;
   num_indices_ = -1;
+  base_vertex_ = 0;
 }
 
-void RenderingComponent::SetDrawRange(int start_index, int num_indices) {
+void RenderingComponent::SetDrawRange(int start_index, int num_indices,
+                                      int base_vertex) {
   start_index_ = start_index;
   num_indices_ = num_indices;
+  base_vertex_ = base_vertex;
 }
 
 void RenderingComponent::Render() const {
@@ -29,13 +33,21 @@ void RenderingComponent::Render() const {
   }
   if (start_index_ >= 0 && num_indices_ > 0) {
     vertex_obj_->GetVertexArray().Render(static_cast<size_t>(start_index_),
-                                         static_cast<size_t>(num_indices_));
+                                         static_cast<size_t>(num_indices_),
+                                         static_cast<size_t>(base_vertex_));
   } else {
-    if (vertex_obj_->HasIndices())
+    if (vertex_obj_->HasIndices()) {
       vertex_obj_->GetVertexArray().Render(0, vertex_obj_->GetIndices().size());
-    else
+    } else if (vertex_obj_->HasCustomVertices()) {
+      size_t count = vertex_obj_->GetCustomVertexCount();
+      // Quad meshes draw six shared indices per four vertices.
+      if (vertex_obj_->GetVertexArray().HasQuadIndices())
+        count = count / 4 * 6;
+      vertex_obj_->GetVertexArray().Render(0, count);
+    } else {
       vertex_obj_->GetVertexArray().Render(0,
                                            vertex_obj_->GetPositions().size());
+    }
   }
 }
 
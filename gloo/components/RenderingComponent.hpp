@@ -9,7 +9,9 @@ namespace GLOO {
 class RenderingComponent : public ComponentBase {
  public:
   RenderingComponent(std::shared_ptr<VertexObject> vertex_obj);
-  void SetDrawRange(int start_index, int num_indices);
+  // base_vertex offsets the indices of the range, for meshes that share
+  // their vertex object with others.
+  void SetDrawRange(int start_index, int num_indices, int base_vertex = 0);
   void SetVertexObject(std::shared_ptr<VertexObject> vertex_obj);
   void SetDrawMode(DrawMode mode);
   void SetPolygonMode(PolygonMode mode);
@@ -23,6 +25,7 @@ class RenderingComponent : public ComponentBase {
   std::shared_ptr<VertexObject> vertex_obj_;
   int start_index_;
   int num_indices_;
+  int base_vertex_;
 };
 
 CREATE_COMPONENT_TRAIT(RenderingComponent, ComponentType::Rendering);
@@ -0,0 +1,68 @@
+#include "QuadIndexBuffer.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "gloo/utils.hpp"
+
+namespace GLOO {
+namespace {
+const unsigned int kQuadPattern[6] = {0, 1, 2, 2, 3, 0};
+
+template <class Index>
+void AppendQuadIndices(size_t quad_count, std::vector<uint8_t>& bytes) {
+  size_t offset = bytes.size();
+  bytes.resize(offset + quad_count * 6 * sizeof(Index));
+  Index* out = reinterpret_cast<Index*>(bytes.data() + offset);
+  for (size_t quad = 0; quad < quad_count; quad++) {
+    for (unsigned int corner : kQuadPattern)
+      *out++ = static_cast<Index>(quad * 4 + corner);
+  }
+}
+
+size_t ShortQuads(size_t quad_count) {
+  return std::min(quad_count, QuadIndexBuffer::kMaxShortQuads);
+}
+}  // namespace
+
+const size_t QuadIndexBuffer::kMaxShortQuads;
+
+QuadIndexBuffer::QuadIndexBuffer(size_t quad_count)
+    : BindableBuffer(GL_ELEMENT_ARRAY_BUFFER), quad_count_(0) {
+  Reserve(quad_count);
+}
+
+void QuadIndexBuffer::Reserve(size_t quad_count) {
+  if (quad_count <= quad_count_)
+    return;
+  std::vector<uint8_t> bytes;
+  AppendQuadIndices<uint16_t>(ShortQuads(quad_count), bytes);
+  if (quad_count > kMaxShortQuads)
+    AppendQuadIndices<uint32_t>(quad_count, bytes);
+  // Through the copy target, so the element buffer binding of whatever VAO
+  // is bound stays untouched.
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, GetHandle()));
+  GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, bytes.size(), bytes.data(),
+                        GL_STATIC_DRAW));
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+  quad_count_ = quad_count;
+}
+
+void QuadIndexBuffer::GetDrawFormat(size_t start_index, size_t num_indices,
+                                    GLenum& type, size_t& byte_offset) const {
+  size_t end_quad = (start_index + num_indices + 5) / 6;
+  if (end_quad > quad_count_)
+    throw std::runtime_error("Quad draw exceeds the quad index buffer!");
+  if (end_quad <= kMaxShortQuads) {
+    type = GL_UNSIGNED_SHORT;
+    byte_offset = start_index * sizeof(uint16_t);
+  } else {
+    type = GL_UNSIGNED_INT;
+    byte_offset = ShortQuads(quad_count_) * 6 * sizeof(uint16_t) +
+                  start_index * sizeof(uint32_t);
+  }
+}
+}  // namespace GLOO
@@ -0,0 +1,42 @@
+#ifndef GLOO_QUAD_INDEX_BUFFER_H_
+#define GLOO_QUAD_INDEX_BUFFER_H_
+
+#include "BindableBuffer.hpp"
+
+#include <cstddef>
+
+namespace GLOO {
+// Pre-built element buffer for meshes made of quads, four vertices per
+// quad: quad q is drawn as triangles (4q, 4q+1, 4q+2) and (4q+2, 4q+3, 4q).
+// Every such mesh can draw from one shared instance instead of building and
+// uploading its own indices; with a base vertex, so can meshes that share a
+// vertex buffer.
+//
+// The buffer holds the pattern twice: as 16-bit indices for the quads that
+// 16 bits can address, followed by 32-bit indices for larger draws. A draw
+// picks the 16-bit copy whenever it fits (see GetDrawFormat).
+class QuadIndexBuffer : public BindableBuffer {
+ public:
+  // Quads a 16-bit index can address.
+  static const size_t kMaxShortQuads = 65536 / 4;
+
+  explicit QuadIndexBuffer(size_t quad_count);
+
+  // Grows the buffer to cover at least quad_count quads. The buffer object
+  // stays the same, so VAOs that bound it need no update.
+  void Reserve(size_t quad_count);
+  size_t GetQuadCount() const {
+    return quad_count_;
+  }
+
+  // Index type and byte offset for drawing num_indices indices starting at
+  // start_index of the pattern.
+  void GetDrawFormat(size_t start_index, size_t num_indices, GLenum& type,
+                     size_t& byte_offset) const;
+
+ private:
+  size_t quad_count_;
+};
+}  // namespace GLOO
+
+#endif
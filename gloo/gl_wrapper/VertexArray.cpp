@@ -1,13 +1,33 @@
 #include "VertexArray.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
 
 #include "BindGuard.hpp"
 #include "gloo/utils.hpp"
 
 namespace GLOO {
+namespace {
+void DrawElements(GLenum draw_mode, size_t num_indices, GLenum index_type,
+                  size_t byte_offset, size_t base_vertex) {
+  const void* offset = reinterpret_cast<const void*>(byte_offset);
+  if (base_vertex != 0) {
+    GL_CHECK(glDrawElementsBaseVertex(draw_mode,
+                                      static_cast<GLsizei>(num_indices),
+                                      index_type, offset,
+                                      static_cast<GLint>(base_vertex)));
+  } else {
+    GL_CHECK(glDrawElements(draw_mode, static_cast<GLsizei>(num_indices),
+                            index_type, offset));
+  }
+}
+}  // namespace
+
 VertexArray::VertexArray()
-    : draw_mode_(DrawMode::Triangles), polygon_mode_(PolygonMode::Fill) {
+    : index_type_(GL_UNSIGNED_INT), index_count_(0),
+      draw_mode_(DrawMode::Triangles), polygon_mode_(PolygonMode::Fill) {
   GL_CHECK(glGenVertexArrays(1, &handle_));
 }
 
@@ -25,6 +45,11 @@ VertexArray::VertexArray(VertexArray&& other) noexcept {
   color_buf_ = std::move(other.color_buf_);
   tex_coord_buf_ = std::move(other.tex_coord_buf_);
   idx_buf_ = std::move(other.idx_buf_);
+  index_type_ = other.index_type_;
+  index_count_ = other.index_count_;
+  quad_idx_buf_ = std::move(other.quad_idx_buf_);
+  custom_buf_ = std::move(other.custom_buf_);
+  custom_layout_ = std::move(other.custom_layout_);
   draw_mode_ = other.draw_mode_;
   polygon_mode_ = other.polygon_mode_;
 }
@@ -38,6 +63,11 @@ VertexArray& VertexArray::operator=(VertexArray&& other) noexcept {
   color_buf_ = std::move(other.color_buf_);
   tex_coord_buf_ = std::move(other.tex_coord_buf_);
   idx_buf_ = std::move(other.idx_buf_);
+  index_type_ = other.index_type_;
+  index_count_ = other.index_count_;
+  quad_idx_buf_ = std::move(other.quad_idx_buf_);
+  custom_buf_ = std::move(other.custom_buf_);
+  custom_layout_ = std::move(other.custom_layout_);
   draw_mode_ = other.draw_mode_;
   polygon_mode_ = other.polygon_mode_;
   return *this;
@@ -68,12 +98,20 @@ void VertexArray::CreateTexCoordBuffer() {
 }
 
 void VertexArray::CreateIndexBuffer() {
+  quad_idx_buf_.reset();
   idx_buf_ = make_unique<IndexBuffer>(GL_STATIC_DRAW);
   BindGuard vao_bg(this);
   // Different from other types of vertex buffers, EBOs should not be unbounded.
   idx_buf_->Bind();
 }
 
+void VertexArray::CreateCustomBuffer(const VertexLayout& layout) {
+  if (layout.GetStride() == 0)
+    throw std::runtime_error("Custom vertex layout has a zero stride!");
+  custom_buf_ = make_unique<CustomBuffer>(GL_STATIC_DRAW);
+  custom_layout_ = layout;
+}
+
 void VertexArray::UpdatePositions(const PositionArray& positions) const {
   pos_buf_->Update(positions);
 }
@@ -90,8 +128,64 @@ void VertexArray::UpdateTexCoords(const TexCoordArray& tex_coords) const {
   tex_coord_buf_->Update(tex_coords);
 }
 
-void VertexArray::UpdateIndices(const IndexArray& indices) const {
-  idx_buf_->Update(indices);
+void VertexArray::UpdateIndices(const IndexArray& indices) {
+  unsigned int max_index = 0;
+  for (unsigned int index : indices)
+    max_index = std::max(max_index, index);
+  if (max_index <= std::numeric_limits<uint16_t>::max()) {
+    std::vector<uint16_t> short_indices(indices.begin(), indices.end());
+    idx_buf_->Update(reinterpret_cast<const uint8_t*>(short_indices.data()),
+                     short_indices.size() * sizeof(uint16_t));
+    index_type_ = GL_UNSIGNED_SHORT;
+  } else {
+    idx_buf_->Update(reinterpret_cast<const uint8_t*>(indices.data()),
+                     indices.size() * sizeof(unsigned int));
+    index_type_ = GL_UNSIGNED_INT;
+  }
+  index_count_ = indices.size();
+}
+
+void VertexArray::UpdateCustomVertices(const void* data,
+                                       size_t vertex_count) const {
+  custom_buf_->Update(static_cast<const uint8_t*>(data),
+                      vertex_count * custom_layout_.GetStride());
+}
+
+void VertexArray::ReallocateCustomVertices(
+    size_t vertex_count, const std::vector<BufferRangeCopy>& copies) {
+  if (custom_buf_ == nullptr)
+    throw std::runtime_error("No custom buffer to reallocate!");
+  size_t stride = custom_layout_.GetStride();
+  auto buffer = make_unique<CustomBuffer>(GL_DYNAMIC_DRAW);
+  buffer->Reserve(vertex_count * stride);
+  for (const BufferRangeCopy& copy : copies) {
+    buffer->CopyRange(*custom_buf_,
+                      {copy.source_first * stride, copy.target_first * stride,
+                       copy.count * stride});
+  }
+  // Shaders link attributes before every draw, so they pick up the new
+  // buffer on their own.
+  custom_buf_ = std::move(buffer);
+}
+
+void VertexArray::UpdateCustomVertexRange(size_t first_vertex,
+                                          const void* data,
+                                          size_t vertex_count) const {
+  size_t stride = custom_layout_.GetStride();
+  custom_buf_->UpdateRange(first_vertex * stride,
+                           static_cast<const uint8_t*>(data),
+                           vertex_count * stride);
+}
+
+void VertexArray::UseQuadIndices(
+    std::shared_ptr<QuadIndexBuffer> quad_indices) {
+  idx_buf_.reset();
+  index_count_ = 0;
+  quad_idx_buf_ = std::move(quad_indices);
+  BindGuard vao_bg(this);
+  // The element buffer binding is VAO state; keep it bound, as in
+  // CreateIndexBuffer.
+  quad_idx_buf_->Bind();
 }
 
 void VertexArray::LinkPositionBuffer(GLuint attr_idx) const {
@@ -126,6 +220,49 @@ void VertexArray::LinkTexCoordBuffer(GLuint attr_idx) const {
   GL_CHECK(glEnableVertexAttribArray(attr_idx));
 }
 
+void VertexArray::LinkCustomAttribute(const std::string& name,
+                                      GLuint attr_idx) const {
+  const VertexAttribute* attribute = custom_layout_.FindAttribute(name);
+  if (attribute == nullptr)
+    throw std::runtime_error("Custom vertex layout has no attribute " + name +
+                             "!");
+  BindGuard vao_bg(this);
+  BindGuard buf_bg(custom_buf_.get());
+  GLsizei stride = static_cast<GLsizei>(custom_layout_.GetStride());
+  const void* offset = reinterpret_cast<const void*>(attribute->offset);
+  if (attribute->integer) {
+    GL_CHECK(glVertexAttribIPointer(attr_idx, attribute->components,
+                                    attribute->type, stride, offset));
+  } else {
+    GL_CHECK(glVertexAttribPointer(attr_idx, attribute->components,
+                                   attribute->type,
+                                   attribute->normalized ? GL_TRUE : GL_FALSE,
+                                   stride, offset));
+  }
+  GL_CHECK(glEnableVertexAttribArray(attr_idx));
+}
+
+void VertexArray::LinkPositions(GLuint attr_idx) const {
+  if (HasPositionBuffer())
+    LinkPositionBuffer(attr_idx);
+  else
+    LinkCustomAttribute(kPositionAttribute, attr_idx);
+}
+
+void VertexArray::LinkNormals(GLuint attr_idx) const {
+  if (HasNormalBuffer())
+    LinkNormalBuffer(attr_idx);
+  else
+    LinkCustomAttribute(kNormalAttribute, attr_idx);
+}
+
+void VertexArray::LinkTexCoords(GLuint attr_idx) const {
+  if (HasTexCoordBuffer())
+    LinkTexCoordBuffer(attr_idx);
+  else
+    LinkCustomAttribute(kTexCoordAttribute, attr_idx);
+}
+
 void VertexArray::SetDrawMode(DrawMode mode) {
   draw_mode_ = mode;
 }
@@ -134,7 +271,8 @@ void VertexArray::SetPolygonMode(PolygonMode mode) {
   polygon_mode_ = mode;
 }
 
-void VertexArray::Render(size_t start_index, size_t num_indices) const {
+void VertexArray::Render(size_t start_index, size_t num_indices,
+                         size_t base_vertex) const {
   // WARNING: need to declare stack variables before RAII
   // to avoid alignment issues.
 
@@ -148,10 +286,18 @@ void VertexArray::Render(size_t start_index, size_t num_indices) const {
 
   GLint draw_mode = draw_mode_ == DrawMode::Triangles ? GL_TRIANGLES : GL_LINES;
 
-  if (idx_buf_ != nullptr) {
-    GL_CHECK(glDrawElements(
-        draw_mode, static_cast<GLsizei>(num_indices), GL_UNSIGNED_INT,
-        reinterpret_cast<void*>(start_index * sizeof(unsigned int))));
+  if (quad_idx_buf_ != nullptr) {
+    GLenum index_type;
+    size_t byte_offset;
+    quad_idx_buf_->GetDrawFormat(start_index, num_indices, index_type,
+                                 byte_offset);
+    DrawElements(draw_mode, num_indices, index_type, byte_offset,
+                 base_vertex);
+  } else if (idx_buf_ != nullptr) {
+    size_t index_size = index_type_ == GL_UNSIGNED_SHORT ? sizeof(uint16_t)
+                                                         : sizeof(uint32_t);
+    DrawElements(draw_mode, num_indices, index_type_,
+                 start_index * index_size, base_vertex);
   } else {
     GL_CHECK(glDrawArrays(draw_mode, (GLint)start_index, (GLsizei)num_indices));
   }
@@ -159,12 +305,15 @@ void VertexArray::Render(size_t start_index, size_t num_indices) const {
 
 void VertexArray::Render() const {
   if (idx_buf_ != nullptr)
-    Render(0, idx_buf_->GetSize());
-  else {
-    if (pos_buf_ == nullptr)
-      throw std::runtime_error("Cannot render VertexArray without positions!");
+    Render(0, index_count_);
+  else if (quad_idx_buf_ != nullptr && custom_buf_ != nullptr)
+    Render(0, custom_buf_->GetSize() / custom_layout_.GetStride() / 4 * 6);
+  else if (pos_buf_ != nullptr)
     Render(0, pos_buf_->GetSize());
-  }
+  else if (custom_buf_ != nullptr)
+    Render(0, custom_buf_->GetSize() / custom_layout_.GetStride());
+  else
+    throw std::runtime_error("Cannot render VertexArray without positions!");
 }
 
 static_assert(std::is_move_constructible<VertexArray>(), "");
@@ -5,7 +5,9 @@
 
 #include "gloo/external.hpp"
 #include "gloo/alias_types.hpp"
+#include "QuadIndexBuffer.hpp"
 #include "VertexBuffer.hpp"
+#include "VertexLayout.hpp"
 
 namespace GLOO {
 enum class DrawMode { Triangles, Lines };
@@ -32,15 +34,35 @@ class VertexArray : public IBindable {
   void CreateColorBuffer();
   void CreateTexCoordBuffer();
   void CreateIndexBuffer();
+  // A custom buffer holds raw vertices in a caller-defined layout, e.g.
+  // packed integers; shaders link its attributes by name.
+  void CreateCustomBuffer(const VertexLayout& layout);
   void UpdatePositions(const PositionArray& positions) const;
   void UpdateNormals(const NormalArray& normals) const;
   void UpdateColors(const ColorArray& colors) const;
   void UpdateTexCoords(const TexCoordArray& tex_coords) const;
-  void UpdateIndices(const IndexArray& indices) const;
+  // Stored as 16-bit indices when every index fits.
+  void UpdateIndices(const IndexArray& indices);
+  // data holds vertex_count vertices of the custom layout's stride.
+  void UpdateCustomVertices(const void* data, size_t vertex_count) const;
+  // Arena storage, shared by meshes drawn from sub-ranges with a base
+  // vertex: the custom buffer gets a fixed capacity and is written range by
+  // range. Reallocating moves to a fresh buffer holding only the given runs
+  // of the old one, copied on the GPU; ranges are in vertices.
+  void ReallocateCustomVertices(size_t vertex_count,
+                                const std::vector<BufferRangeCopy>& copies);
+  void UpdateCustomVertexRange(size_t first_vertex, const void* data,
+                               size_t vertex_count) const;
+  // Draws from a shared quad index buffer instead of an own index buffer,
+  // for meshes made of four-vertex quads.
+  void UseQuadIndices(std::shared_ptr<QuadIndexBuffer> quad_indices);
   void LinkPositionBuffer(GLuint attr_idx) const;
   void LinkNormalBuffer(GLuint attr_idx) const;
   void LinkColorBuffer(GLuint attr_idx) const;
   void LinkTexCoordBuffer(GLuint attr_idx) const;
+  // Links the custom layout's attribute called name; throws if the layout
+  // has no such attribute.
+  void LinkCustomAttribute(const std::string& name, GLuint attr_idx) const;
 
   bool HasPositionBuffer() const {
     return pos_buf_ != nullptr;
@@ -62,9 +84,44 @@ class VertexArray : public IBindable {
     return idx_buf_ != nullptr;
   }
 
+  bool HasQuadIndices() const {
+    return quad_idx_buf_ != nullptr;
+  }
+
+  bool HasCustomBuffer() const {
+    return custom_buf_ != nullptr;
+  }
+
+  const VertexLayout& GetCustomLayout() const {
+    return custom_layout_;
+  }
+
+  bool HasCustomAttribute(const std::string& name) const {
+    return custom_buf_ != nullptr &&
+           custom_layout_.FindAttribute(name) != nullptr;
+  }
+
+  // The standard vertex streams, from either their own buffer or an
+  // interleaved custom buffer with the matching attribute (the separate
+  // buffer wins if both exist).
+  bool HasPositions() const {
+    return HasPositionBuffer() || HasCustomAttribute(kPositionAttribute);
+  }
+  bool HasNormals() const {
+    return HasNormalBuffer() || HasCustomAttribute(kNormalAttribute);
+  }
+  bool HasTexCoords() const {
+    return HasTexCoordBuffer() || HasCustomAttribute(kTexCoordAttribute);
+  }
+  void LinkPositions(GLuint attr_idx) const;
+  void LinkNormals(GLuint attr_idx) const;
+  void LinkTexCoords(GLuint attr_idx) const;
+
   void SetDrawMode(DrawMode mode);
   void SetPolygonMode(PolygonMode mode);
-  void Render(size_t start_index, size_t num_indices) const;
+  // base_vertex is added to every index read, for indexed drawing.
+  void Render(size_t start_index, size_t num_indices,
+              size_t base_vertex = 0) const;
   void Render() const;
 
  private:
@@ -73,13 +130,21 @@ class VertexArray : public IBindable {
   using NormalBuffer = VertexBuffer<glm::vec3, GL_ARRAY_BUFFER>;
   using ColorBuffer = VertexBuffer<glm::vec4, GL_ARRAY_BUFFER>;
   using TexCoordBuffer = VertexBuffer<glm::vec2, GL_ARRAY_BUFFER>;
-  using IndexBuffer = VertexBuffer<unsigned int, GL_ELEMENT_ARRAY_BUFFER>;
+  // Indices are stored as 16-bit values when they all fit, 32-bit
+  // otherwise; index_type_ says which.
+  using IndexBuffer = VertexBuffer<uint8_t, GL_ELEMENT_ARRAY_BUFFER>;
+  using CustomBuffer = VertexBuffer<uint8_t, GL_ARRAY_BUFFER>;
 
   std::unique_ptr<PositionBuffer> pos_buf_;
   std::unique_ptr<NormalBuffer> normal_buf_;
   std::unique_ptr<ColorBuffer> color_buf_;
   std::unique_ptr<TexCoordBuffer> tex_coord_buf_;
   std::unique_ptr<IndexBuffer> idx_buf_;
+  GLenum index_type_;
+  size_t index_count_;
+  std::shared_ptr<QuadIndexBuffer> quad_idx_buf_;
+  std::unique_ptr<CustomBuffer> custom_buf_;
+  VertexLayout custom_layout_;
 
   DrawMode draw_mode_;
   PolygonMode polygon_mode_;
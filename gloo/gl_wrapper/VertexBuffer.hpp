@@ -3,6 +3,7 @@
 
 #include "BindableBuffer.hpp"
 
+#include <stdexcept>
 #include <vector>
 
 #include <glad/glad.h>
@@ -11,17 +12,35 @@
 #include "gloo/utils.hpp"
 
 namespace GLOO {
+// A run of elements to carry over into a reallocated buffer.
+struct BufferRangeCopy {
+  size_t source_first;
+  size_t target_first;
+  size_t count;
+};
+
 template <class T, GLenum target>
 class VertexBuffer : public BindableBuffer {
  public:
   VertexBuffer(GLenum usage);
   void Update(const std::vector<T>& array);
+  void Update(const T* data, size_t count);
   size_t GetSize() const {
     return size_;
   }
 
+  // Range access, for buffers sub-allocated between several meshes. These
+  // go through the copy targets, so they can be used on index buffers
+  // without disturbing the element buffer binding of the bound VAO.
+  //
+  // Allocates storage for count elements with undefined contents.
+  void Reserve(size_t count);
+  void UpdateRange(size_t first, const T* data, size_t count);
+  // Copies elements from another buffer on the GPU.
+  void CopyRange(const VertexBuffer& source, const BufferRangeCopy& copy);
+
  private:
-  size_t size_;
+  size_t size_ = 0;
   GLenum usage_;
 };
 
@@ -32,10 +51,50 @@ VertexBuffer<T, target>::VertexBuffer(GLenum usage)
 
 template <class T, GLenum target>
 void VertexBuffer<T, target>::Update(const std::vector<T>& array) {
+  Update(array.data(), array.size());
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::Update(const T* data, size_t count) {
   BindGuard bg(this);
-  GL_CHECK(
-      glBufferData(target_, sizeof(T) * array.size(), array.data(), usage_));
-  size_ = array.size();
+  GL_CHECK(glBufferData(target_, sizeof(T) * count, data, usage_));
+  size_ = count;
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::Reserve(size_t count) {
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, GetHandle()));
+  GL_CHECK(glBufferData(GL_COPY_WRITE_BUFFER, sizeof(T) * count, nullptr,
+                        usage_));
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+  size_ = count;
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::UpdateRange(size_t first, const T* data,
+                                          size_t count) {
+  if (first + count > size_)
+    throw std::runtime_error("Buffer range update out of bounds!");
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, GetHandle()));
+  GL_CHECK(glBufferSubData(GL_COPY_WRITE_BUFFER, sizeof(T) * first,
+                           sizeof(T) * count, data));
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+}
+
+template <class T, GLenum target>
+void VertexBuffer<T, target>::CopyRange(const VertexBuffer& source,
+                                        const BufferRangeCopy& copy) {
+  if (copy.source_first + copy.count > source.size_ ||
+      copy.target_first + copy.count > size_)
+    throw std::runtime_error("Buffer range copy out of bounds!");
+  GL_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, source.GetHandle()));
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, GetHandle()));
+  GL_CHECK(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                               sizeof(T) * copy.source_first,
+                               sizeof(T) * copy.target_first,
+                               sizeof(T) * copy.count));
+  GL_CHECK(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+  GL_CHECK(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
 }
 }  // namespace GLOO
 
@@ -0,0 +1,84 @@
+#ifndef GLOO_VERTEX_LAYOUT_H_
+#define GLOO_VERTEX_LAYOUT_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <glad/glad.h>
+
+namespace GLOO {
+// Attribute names of the standard vertex streams. Interleaved layouts that
+// use them can stand in for the separate position/normal/tex-coord buffers.
+const char* const kPositionAttribute = "vertex_position";
+const char* const kNormalAttribute = "vertex_normal";
+const char* const kTexCoordAttribute = "vertex_tex_coord";
+
+// How one shader input is read from a vertex buffer with a custom layout.
+struct VertexAttribute {
+  // Name of the shader input it feeds.
+  std::string name;
+  GLint components;
+  // Component type, e.g. GL_FLOAT or GL_UNSIGNED_INT.
+  GLenum type;
+  // Integer attributes reach the shader as ints/uints through
+  // glVertexAttribIPointer instead of being converted to float.
+  bool integer;
+  // Only for non-integer attributes with an integer type: map the value
+  // range to [0, 1] (or [-1, 1]) instead of converting as-is.
+  bool normalized;
+  // Byte offset of the attribute inside one vertex.
+  size_t offset;
+};
+
+// Byte layout of one vertex in a custom vertex buffer: its size and the
+// attributes stored in it, e.g. a single packed 32-bit integer or a struct
+// of several fields.
+class VertexLayout {
+ public:
+  explicit VertexLayout(size_t stride = 0) : stride_(stride) {
+  }
+
+  VertexLayout& AddFloatAttribute(const std::string& name,
+                                  GLint components,
+                                  size_t offset) {
+    attributes_.push_back({name, components, GL_FLOAT, false, false, offset});
+    return *this;
+  }
+  VertexLayout& AddIntegerAttribute(const std::string& name,
+                                    GLint components,
+                                    GLenum type,
+                                    size_t offset) {
+    attributes_.push_back({name, components, type, true, false, offset});
+    return *this;
+  }
+  VertexLayout& AddNormalizedAttribute(const std::string& name,
+                                       GLint components,
+                                       GLenum type,
+                                       size_t offset) {
+    attributes_.push_back({name, components, type, false, true, offset});
+    return *this;
+  }
+
+  size_t GetStride() const {
+    return stride_;
+  }
+  const std::vector<VertexAttribute>& GetAttributes() const {
+    return attributes_;
+  }
+  // Returns nullptr if the layout has no attribute with that name.
+  const VertexAttribute* FindAttribute(const std::string& name) const {
+    for (const VertexAttribute& attribute : attributes_) {
+      if (attribute.name == name)
+        return &attribute;
+    }
+    return nullptr;
+  }
+
+ private:
+  size_t stride_;
+  std::vector<VertexAttribute> attributes_;
+};
+}  // namespace GLOO
+
+#endif
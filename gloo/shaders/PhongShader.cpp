@@ -22,18 +22,18 @@ PhongShader::PhongShader()
 }
 
 void PhongShader::AssociateVertexArray(VertexArray& vertex_array) const {
-  if (!vertex_array.HasPositionBuffer()) {
+  if (!vertex_array.HasPositions()) {
     throw std::runtime_error("Phong shader requires vertex positions!");
   }
-  if (!vertex_array.HasNormalBuffer()) {
+  if (!vertex_array.HasNormals()) {
     throw std::runtime_error("Phong shader requires vertex normals!");
   }
-  vertex_array.LinkPositionBuffer(GetAttributeLocation("vertex_position"));
-  vertex_array.LinkNormalBuffer(GetAttributeLocation("vertex_normal"));
-  if (vertex_array.HasTexCoordBuffer()) {
+  vertex_array.LinkPositions(GetAttributeLocation("vertex_position"));
+  vertex_array.LinkNormals(GetAttributeLocation("vertex_normal"));
+  if (vertex_array.HasTexCoords()) {
     GLint loc = GetAttributeLocation("vertex_tex_coord");
     if (loc != -1) {
-      vertex_array.LinkTexCoordBuffer(loc);
+      vertex_array.LinkTexCoords(loc);
     }
   }
 }
@@ -12,15 +12,15 @@ PlainTextureShader::PlainTextureShader()
 
 void PlainTextureShader::AssociateVertexArray(
     const VertexArray& vertex_array) const {
-  if (!vertex_array.HasPositionBuffer()) {
+  if (!vertex_array.HasPositions()) {
     throw std::runtime_error("Plain texture shader requires vertex positions!");
   }
-  if (!vertex_array.HasTexCoordBuffer()) {
+  if (!vertex_array.HasTexCoords()) {
     throw std::runtime_error(
         "Plain texture shader requires vertex texture coordinates!");
   }
-  vertex_array.LinkPositionBuffer(GetAttributeLocation("vertex_ndc_position"));
-  vertex_array.LinkTexCoordBuffer(GetAttributeLocation("vertex_tex_coord"));
+  vertex_array.LinkPositions(GetAttributeLocation("vertex_ndc_position"));
+  vertex_array.LinkTexCoords(GetAttributeLocation("vertex_tex_coord"));
 }
 
 void PlainTextureShader::SetVertexObject(const VertexObject& obj) const {
@@ -132,4 +132,14 @@ void ShaderProgram::SetUniform(const std::string& name, int value) const {
   GL_CHECK_ERROR();
   GL_CHECK(glUniform1i(loc, value));
 }
+
+void ShaderProgram::SetUniform(const std::string& name,
+                               const std::vector<glm::vec3>& values) const {
+  if (values.empty())
+    return;
+  GLint loc = glGetUniformLocation(shader_program_, (name + "[0]").c_str());
+  GL_CHECK_ERROR();
+  GL_CHECK(glUniform3fv(loc, static_cast<GLsizei>(values.size()),
+                        glm::value_ptr(values[0])));
+}
 }  // namespace GLOO
@@ -4,6 +4,7 @@
 #include "gloo/gl_wrapper/IBindable.hpp"
 
 #include <string>
+#include <vector>
 #include <unordered_map>
 
 #include <glad/glad.h>
@@ -46,6 +47,9 @@ class ShaderProgram : public IBindable {
   void SetUniform(const std::string& name, const glm::vec3& value) const;
   void SetUniform(const std::string& name, float value) const;
   void SetUniform(const std::string& name, int value) const;
+  // Sets the uniform array `name` starting at element 0.
+  void SetUniform(const std::string& name,
+                  const std::vector<glm::vec3>& values) const;
 
  private:
   static GLuint LoadShader(GLenum type,
@@ -20,10 +20,17 @@ namespace GLOO {
     }
 
     void ShadowShader::AssociateVertexArray(VertexArray& vertex_array) const {
-        if (!vertex_array.HasPositionBuffer()) {
+        // Meshes either have float positions or packed voxel vertices
+        // (see VoxelShader.hpp); shadow.vert decodes whichever is linked.
+        if (vertex_array.HasPositions()) {
+            vertex_array.LinkPositions(GetAttributeLocation("vertex_position"));
+            SetUniform("packed_vertices", false);
+        } else if (vertex_array.HasCustomAttribute("vertex_data")) {
+            vertex_array.LinkCustomAttribute("vertex_data", GetAttributeLocation("vertex_data"));
+            SetUniform("packed_vertices", true);
+        } else {
             throw std::runtime_error("Shadow shader requires vertex positions!");
         }
-        vertex_array.LinkPositionBuffer(GetAttributeLocation("vertex_position"));
     }
 
     void ShadowShader::SetTargetNode(const SceneNode& node,
@@ -21,10 +21,10 @@ SimpleShader::SimpleShader()
 }
 
 void SimpleShader::AssociateVertexArray(VertexArray& vertex_array) const {
-  if (!vertex_array.HasPositionBuffer()) {
+  if (!vertex_array.HasPositions()) {
     throw std::runtime_error("Simple shader requires vertex positions!");
   }
-  vertex_array.LinkPositionBuffer(GetAttributeLocation("vertex_position"));
+  vertex_array.LinkPositions(GetAttributeLocation("vertex_position"));
 }
 
 void SimpleShader::SetTargetNode(const SceneNode& node,
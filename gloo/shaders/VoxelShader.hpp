@@ -0,0 +1,47 @@
+#ifndef GLOO_VOXEL_SHADER_H_
+#define GLOO_VOXEL_SHADER_H_
+
+#include <vector>
+
+#include "ShaderProgram.hpp"
+
+namespace GLOO {
+// Phong-style shading for voxel meshes whose vertices are packed into one
+// 32-bit unsigned integer (read with glVertexAttribIPointer):
+//
+//   bits  0-17  position in the chunk, 6 bits per axis (0 to 32)
+//   bits 18-20  face direction: +x, -x, +y, -y, +z, -z
+//   bits 21-22  ambient occlusion level, 3 means unoccluded
+//   bits 23-31  texture layer
+//
+// That is 4 bytes per vertex instead of 24 for a float position and
+// normal. The layer selects the surface color from SetLayerColors();
+// specular color and shininess come from the node's material.
+class VoxelShader : public ShaderProgram {
+ public:
+  // Must match the size of layer_colors in voxel.frag. Higher layers are
+  // drawn with the last color.
+  static const int kMaxLayers = 64;
+
+  VoxelShader();
+
+  static VertexLayout GetVertexLayout();
+
+  void SetLayerColors(std::vector<glm::vec3> colors);
+
+  void SetTargetNode(const SceneNode& node,
+                     const glm::mat4& model_matrix) const override;
+  void SetCamera(const CameraComponent& camera) const override;
+  void SetLightSource(const LightComponent& component) const override;
+  void SetShadowMapping(
+      const Texture& shadow_texture,
+      const glm::mat4& world_to_light_ndc_matrix) const override;
+
+ private:
+  void AssociateVertexArray(VertexArray& vertex_array) const;
+
+  std::vector<glm::vec3> layer_colors_;
+};
+}  // namespace GLOO
+
+#endif
@@ -2,10 +2,20 @@
 
 uniform mat4 model_matrix;
 uniform mat4 world_to_light_ndc_matrix;
+// Whether the mesh uses packed voxel vertices (see VoxelShader.hpp)
+// instead of float positions.
+uniform bool packed_vertices;
 
 layout(location = 0) in vec3 vertex_position;
+layout(location = 1) in uint vertex_data;
 
 void main() {
-    vec3 world_position = vec3(model_matrix * vec4(vertex_position, 1.0));
+    vec3 position = vertex_position;
+    if (packed_vertices) {
+        position = vec3(vertex_data & 63u,
+                        (vertex_data >> 6u) & 63u,
+                        (vertex_data >> 12u) & 63u);
+    }
+    vec3 world_position = vec3(model_matrix * vec4(position, 1.0));
     gl_Position = world_to_light_ndc_matrix * vec4(world_position, 1.0);
 }
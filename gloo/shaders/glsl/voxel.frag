@@ -0,0 +1,118 @@
+#version 330 core
+
+out vec4 frag_color;
+
+struct AmbientLight {
+    bool enabled;
+    vec3 ambient;
+};
+
+struct PointLight {
+    bool enabled;
+    vec3 position;
+    vec3 diffuse;
+    vec3 specular;
+    vec3 attenuation;
+};
+
+struct DirectionalLight {
+    bool enabled;
+    vec3 direction;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct Material {
+    vec3 specular;
+    float shininess;
+};
+
+in vec3 world_position;
+in vec3 world_normal;
+in float ambient_occlusion;
+flat in uint layer;
+
+uniform vec3 camera_position;
+
+uniform Material material;
+uniform AmbientLight ambient_light;
+uniform PointLight point_light;
+uniform DirectionalLight directional_light;
+
+// Surface color per texture layer; must match VoxelShader::kMaxLayers.
+uniform vec3 layer_colors[64];
+uniform int layer_count;
+
+uniform sampler2D shadow_texture;
+uniform mat4 world_to_light_ndc_matrix;
+
+vec3 CalcPointLight(vec3 color, vec3 normal, vec3 view_dir);
+vec3 CalcDirectionalLight(vec3 color, vec3 normal, vec3 view_dir);
+
+void main() {
+    vec3 normal = normalize(world_normal);
+    vec3 view_dir = normalize(camera_position - world_position);
+    vec3 color = layer_colors[min(int(layer), layer_count - 1)];
+
+    frag_color = vec4(0.0);
+
+    if (ambient_light.enabled) {
+        frag_color += vec4(ambient_light.ambient * color * ambient_occlusion, 1.0);
+    }
+
+    if (point_light.enabled) {
+        frag_color += vec4(CalcPointLight(color, normal, view_dir), 1.0);
+    }
+
+    if (directional_light.enabled) {
+        frag_color += vec4(CalcDirectionalLight(color, normal, view_dir), 1.0);
+    }
+}
+
+vec3 CalcPointLight(vec3 color, vec3 normal, vec3 view_dir) {
+    PointLight light = point_light;
+    vec3 light_dir = normalize(light.position - world_position);
+
+    float diffuse_intensity = max(dot(normal, light_dir), 0.0);
+    vec3 diffuse_color = diffuse_intensity * light.diffuse * color;
+
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float specular_intensity = pow(
+        max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+    vec3 specular_color = specular_intensity *
+        light.specular * material.specular;
+
+    float distance = length(light.position - world_position);
+    float attenuation = 1.0 / (light.attenuation.x +
+        light.attenuation.y * distance +
+        light.attenuation.z * (distance * distance));
+
+    return attenuation * (diffuse_color + specular_color);
+}
+
+vec3 CalcDirectionalLight(vec3 color, vec3 normal, vec3 view_dir) {
+    DirectionalLight light = directional_light;
+    vec3 light_dir = normalize(-light.direction);
+    float diffuse_intensity = max(dot(normal, light_dir), 0.0);
+    vec3 diffuse_color = diffuse_intensity * light.diffuse * color;
+
+    vec3 reflect_dir = reflect(-light_dir, normal);
+    float specular_intensity = pow(
+        max(dot(view_dir, reflect_dir), 0.0), material.shininess);
+    vec3 specular_color = specular_intensity *
+        light.specular * material.specular;
+
+    vec3 final_color = diffuse_color + specular_color;
+
+    // Shadow computations, as in phong.frag.
+    vec4 x_ndc = world_to_light_ndc_matrix * vec4(world_position, 1.0f);
+    vec4 x_tex = (x_ndc + vec4(1.0f)) * 0.5f;
+    float this_depth = x_tex.z;
+    float occluder_depth = texture(shadow_texture, x_tex.xy).r;
+    float bias = 0.005f;
+    if (occluder_depth + bias < this_depth){
+        final_color *= occluder_depth + bias;
+    }
+
+    return final_color;
+}
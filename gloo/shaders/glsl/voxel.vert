@@ -0,0 +1,35 @@
+#version 330 core
+
+uniform mat4 model_matrix;
+uniform mat3 normal_matrix;
+uniform mat4 view_matrix;
+uniform mat4 projection_matrix;
+
+// Packed vertex, see VoxelShader.hpp for the bit layout.
+layout(location = 0) in uint vertex_data;
+
+out vec3 world_position;
+out vec3 world_normal;
+out float ambient_occlusion;
+flat out uint layer;
+
+const vec3 kFaceNormals[6] = vec3[6](
+    vec3(1.0, 0.0, 0.0), vec3(-1.0, 0.0, 0.0),
+    vec3(0.0, 1.0, 0.0), vec3(0.0, -1.0, 0.0),
+    vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0));
+
+void main() {
+    vec3 local_position = vec3(vertex_data & 63u,
+                               (vertex_data >> 6u) & 63u,
+                               (vertex_data >> 12u) & 63u);
+    uint face = min((vertex_data >> 18u) & 7u, 5u);
+    uint ao_level = (vertex_data >> 21u) & 3u;
+    layer = vertex_data >> 23u;
+
+    world_position = vec3(model_matrix * vec4(local_position, 1.0));
+    world_normal = normal_matrix * kFaceNormals[face];
+    // Fully occluded corners keep some light so caves are not pitch black.
+    ambient_occlusion = 0.4 + 0.2 * float(ao_level);
+
+    gl_Position = projection_matrix * view_matrix * vec4(world_position, 1.0);
+}
@@ -0,0 +1,37 @@
+#ifndef BENCHMARK_UTILS_H_
+#define BENCHMARK_UTILS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace GLOO {
+// Runs fn() `runs` times after one warm-up call and returns the median
+// wall-clock time of a single call, in microseconds.
+template <typename Fn>
+double MedianMicroseconds(int runs, Fn fn) {
+  using Clock = std::chrono::high_resolution_clock;
+  fn();
+  std::vector<double> samples;
+  for (int i = 0; i < runs; i++) {
+    auto start = Clock::now();
+    fn();
+    auto end = Clock::now();
+    samples.push_back(
+        std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  std::sort(samples.begin(), samples.end());
+  return samples[samples.size() / 2];
+}
+
+// Keeps the optimizer from discarding benchmark results.
+template <typename T>
+void DoNotOptimize(const T& value) {
+  static volatile const T* sink;
+  sink = &value;
+  (void)sink;
+}
+}  // namespace GLOO
+
+#endif
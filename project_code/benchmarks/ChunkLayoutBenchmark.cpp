@@ -0,0 +1,183 @@
+// Compares the linear and Morton chunk layouts on the access patterns of
+// meshing (6-neighbour face tests), flood fill (BFS through air) and
+// raycasting (3D DDA). Each workload runs over a raw array of block IDs
+// indexed through the layout under test, so the numbers isolate the memory
+// order from the palette decoding in VoxelStorage.
+
+#include <cstdint>
+#include <cstdio>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "storage/Chunk.hpp"
+#include "BenchmarkUtils.hpp"
+
+using namespace GLOO;
+
+namespace {
+const int kRuns = 25;
+const int kRayCount = 4096;
+
+struct Ray {
+  glm::vec3 origin;
+  glm::vec3 direction;
+};
+
+bool InBounds(int x, int y, int z) {
+  return x >= 0 && y >= 0 && z >= 0 && x < kChunkSize && y < kChunkSize &&
+         z < kChunkSize;
+}
+
+// Rolling terrain with a few spherical caves, stored in layout order.
+template <typename Layout>
+std::vector<uint16_t> MakeTerrain() {
+  std::vector<uint16_t> voxels(kChunkVolume, 0);
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<float> coord(0.0f, float(kChunkSize));
+  std::vector<glm::vec4> caves;
+  for (int i = 0; i < 6; i++)
+    caves.emplace_back(coord(rng), coord(rng) * 0.5f, coord(rng), 3.0f + i);
+
+  for (int z = 0; z < kChunkSize; z++) {
+    for (int y = 0; y < kChunkSize; y++) {
+      for (int x = 0; x < kChunkSize; x++) {
+        float height = kChunkSize * 0.5f + 4.0f * std::sin(x * 0.3f) +
+                       3.0f * std::cos(z * 0.25f);
+        bool solid = y < height;
+        for (const glm::vec4& cave : caves) {
+          if (glm::length(glm::vec3(x, y, z) - glm::vec3(cave)) < cave.w)
+            solid = false;
+        }
+        if (solid)
+          voxels[Layout::Index(x, y, z)] = y < height - 3 ? 2 : 1;
+      }
+    }
+  }
+  return voxels;
+}
+
+template <typename Layout>
+uint32_t CountVisibleFaces(const std::vector<uint16_t>& voxels) {
+  static const int kOffsets[6][3] = {{1, 0, 0},  {-1, 0, 0}, {0, 1, 0},
+                                     {0, -1, 0}, {0, 0, 1},  {0, 0, -1}};
+  uint32_t faces = 0;
+  for (int z = 0; z < kChunkSize; z++) {
+    for (int y = 0; y < kChunkSize; y++) {
+      for (int x = 0; x < kChunkSize; x++) {
+        if (voxels[Layout::Index(x, y, z)] == 0)
+          continue;
+        for (const auto& o : kOffsets) {
+          int nx = x + o[0], ny = y + o[1], nz = z + o[2];
+          if (!InBounds(nx, ny, nz) || voxels[Layout::Index(nx, ny, nz)] == 0)
+            faces++;
+        }
+      }
+    }
+  }
+  return faces;
+}
+
+template <typename Layout>
+uint32_t FloodFillAir(const std::vector<uint16_t>& voxels) {
+  std::vector<uint8_t> visited(kChunkVolume, 0);
+  std::vector<uint32_t> queue;
+  queue.reserve(kChunkVolume);
+  uint32_t start = Layout::Index(0, kChunkSize - 1, 0);
+  queue.push_back(start);
+  visited[start] = 1;
+  static const int kOffsets[6][3] = {{1, 0, 0},  {-1, 0, 0}, {0, 1, 0},
+                                     {0, -1, 0}, {0, 0, 1},  {0, 0, -1}};
+  for (size_t head = 0; head < queue.size(); head++) {
+    glm::ivec3 p = Layout::Decode(queue[head]);
+    for (const auto& o : kOffsets) {
+      int nx = p.x + o[0], ny = p.y + o[1], nz = p.z + o[2];
+      if (!InBounds(nx, ny, nz))
+        continue;
+      uint32_t index = Layout::Index(nx, ny, nz);
+      if (visited[index] || voxels[index] != 0)
+        continue;
+      visited[index] = 1;
+      queue.push_back(index);
+    }
+  }
+  return static_cast<uint32_t>(queue.size());
+}
+
+// Amanatides-Woo voxel traversal; returns the number of rays that hit.
+template <typename Layout>
+uint32_t CastRays(const std::vector<uint16_t>& voxels,
+                  const std::vector<Ray>& rays) {
+  uint32_t hits = 0;
+  for (const Ray& ray : rays) {
+    glm::ivec3 cell(glm::floor(ray.origin));
+    glm::ivec3 step(ray.direction.x > 0 ? 1 : -1, ray.direction.y > 0 ? 1 : -1,
+                    ray.direction.z > 0 ? 1 : -1);
+    glm::vec3 delta = glm::abs(1.0f / ray.direction);
+    glm::vec3 next_boundary = glm::vec3(cell) + glm::max(glm::vec3(step), 0.0f);
+    glm::vec3 t_max = (next_boundary - ray.origin) / ray.direction;
+    while (InBounds(cell.x, cell.y, cell.z)) {
+      if (voxels[Layout::Index(cell.x, cell.y, cell.z)] != 0) {
+        hits++;
+        break;
+      }
+      if (t_max.x < t_max.y && t_max.x < t_max.z) {
+        cell.x += step.x;
+        t_max.x += delta.x;
+      } else if (t_max.y < t_max.z) {
+        cell.y += step.y;
+        t_max.y += delta.y;
+      } else {
+        cell.z += step.z;
+        t_max.z += delta.z;
+      }
+    }
+  }
+  return hits;
+}
+
+std::vector<Ray> MakeRays() {
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> coord(0.5f, kChunkSize - 0.5f);
+  std::uniform_real_distribution<float> dir(-1.0f, 1.0f);
+  std::vector<Ray> rays;
+  for (int i = 0; i < kRayCount; i++) {
+    glm::vec3 d(dir(rng), dir(rng) - 0.5f, dir(rng));
+    // Avoid exact zeros so the DDA never divides by zero.
+    d += glm::vec3(1e-4f);
+    rays.push_back({glm::vec3(coord(rng), kChunkSize - 0.5f, coord(rng)),
+                    glm::normalize(d)});
+  }
+  return rays;
+}
+
+template <typename Layout>
+void RunLayout(const char* name, const std::vector<Ray>& rays) {
+  std::vector<uint16_t> voxels = MakeTerrain<Layout>();
+  uint32_t faces = 0, filled = 0, hits = 0;
+  double mesh_us = MedianMicroseconds(
+      kRuns, [&]() { faces = CountVisibleFaces<Layout>(voxels); });
+  double fill_us =
+      MedianMicroseconds(kRuns, [&]() { filled = FloodFillAir<Layout>(voxels); });
+  double ray_us =
+      MedianMicroseconds(kRuns, [&]() { hits = CastRays<Layout>(voxels, rays); });
+  std::printf("%-8s %12.1f %12.1f %12.1f   (faces %u, filled %u, hits %u)\n",
+              name, mesh_us, fill_us, ray_us, faces, filled, hits);
+}
+}  // namespace
+
+int main() {
+  std::printf("Chunk layout benchmark, %d^3 chunk, median of %d runs (us)\n",
+              kChunkSize, kRuns);
+#if defined(__BMI2__)
+  std::printf("Morton encode: PDEP/PEXT\n");
+#else
+  std::printf("Morton encode: lookup table\n");
+#endif
+  std::printf("%-8s %12s %12s %12s\n", "layout", "meshing", "flood fill",
+              "raycast");
+  std::vector<Ray> rays = MakeRays();
+  RunLayout<LinearChunkLayout<kChunkSizeLog2>>("linear", rays);
+  RunLayout<MortonChunkLayout<kChunkSizeLog2>>("morton", rays);
+  return 0;
+}
@@ -0,0 +1,251 @@
+// Meshes a few representative chunk neighbourhoods with every mesher mode
+// and every coarse level of detail, plus the binary mesher behind a warm
+// mesh cache, and reports the output size and the median meshing time per
+// chunk. Times include copying the neighbourhood into the padded voxel
+// buffer but not uploading anything, so no GL context is needed. The
+// "kernel" row times the bitmask kernel alone, from padded voxels to quads.
+//
+// With --verify [iterations], instead meshes random neighbourhoods and
+// checks that the bitmask kernel emits exactly the quads of the scalar
+// greedy mesher, and that greedy quads cover exactly the culled faces with
+// the same AO.
+// Exits with a non-zero status on the first mismatch.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <random>
+#include <set>
+#include <tuple>
+#include <vector>
+
+#include "meshing/BinaryChunkMesher.hpp"
+#include "meshing/ChunkMeshCache.hpp"
+#include "meshing/ChunkMesher.hpp"
+#include "BenchmarkUtils.hpp"
+
+using namespace GLOO;
+
+namespace {
+const int kRuns = 50;
+const int kDefaultVerifyIterations = 500;
+// Throughput goal for the bitmask kernel on terrain chunks, without the
+// padded copy and the vertex build that every mode pays for.
+const double kTargetMicroseconds = 250.0;
+
+// Block at a world position.
+using Scene = std::function<VoxelType(const glm::ivec3&)>;
+
+VoxelType FlatTerrain(const glm::ivec3& p) {
+  if (p.y < 12)
+    return VoxelType::Stone;
+  if (p.y < 15)
+    return VoxelType::Dirt;
+  return p.y == 15 ? VoxelType::Grass : VoxelType::Air;
+}
+
+VoxelType RollingTerrain(const glm::ivec3& p) {
+  float height = 16.0f + 5.0f * std::sin(p.x * 0.15f) +
+                 4.0f * std::cos(p.z * 0.11f + 1.0f);
+  float cave = std::sin(p.x * 0.35f) * std::sin(p.y * 0.4f) *
+               std::sin(p.z * 0.3f);
+  if (p.y >= height || cave > 0.6f)
+    return p.y < 10 ? VoxelType::Water : VoxelType::Air;
+  if (p.y < height - 4)
+    return VoxelType::Stone;
+  return p.y + 1 >= height ? VoxelType::Grass : VoxelType::Dirt;
+}
+
+VoxelType RandomNoise(const glm::ivec3& p) {
+  uint32_t h = static_cast<uint32_t>(p.x) * 73856093u ^
+               static_cast<uint32_t>(p.y) * 19349663u ^
+               static_cast<uint32_t>(p.z) * 83492791u;
+  h ^= h >> 13;
+  h *= 0x5bd1e995u;
+  h ^= h >> 15;
+  return (h & 1) ? VoxelType::Stone : VoxelType::Air;
+}
+
+// Generates the center chunk at the origin and its 26 neighbours.
+ChunkNeighborhood MakeNeighborhood(const Scene& scene) {
+  ChunkNeighborhood neighborhood(ChunkCoord(0));
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        glm::ivec3 offset(dx, dy, dz);
+        Chunk chunk(offset);
+        glm::ivec3 origin = chunk.GetOrigin();
+        for (int z = 0; z < kChunkSize; z++)
+          for (int y = 0; y < kChunkSize; y++)
+            for (int x = 0; x < kChunkSize; x++)
+              chunk.Set(x, y, z, Voxel(scene(origin + glm::ivec3(x, y, z))));
+        chunk.Compact();
+        neighborhood.SetChunk(offset, chunk.Snapshot());
+      }
+    }
+  }
+  return neighborhood;
+}
+
+double RunMode(const char* name, const ChunkNeighborhood& neighborhood,
+               MesherMode mode, int lod = 0, ChunkMeshCache* cache = nullptr) {
+  ChunkMeshData mesh;
+  double us = MedianMicroseconds(kRuns, [&]() {
+    mesh = ChunkMesher::Mesh(neighborhood, mode, lod, cache);
+  });
+  DoNotOptimize(mesh);
+  std::printf("  %-8s %10zu %10zu %10zu %12.1f\n", name,
+              mesh.GetQuadCount() * 2, mesh.vertices.size(),
+              mesh.GetByteSize(), us);
+  return us;
+}
+
+double RunKernel(const ChunkNeighborhood& neighborhood) {
+  std::unique_ptr<PaddedChunkVoxels> voxels(
+      new PaddedChunkVoxels(neighborhood));
+  std::vector<ChunkQuad> quads;
+  double us = MedianMicroseconds(kRuns, [&]() {
+    quads.clear();
+    BinaryChunkMesher::CollectGreedyQuads(*voxels, quads);
+  });
+  DoNotOptimize(quads);
+  std::printf("  %-8s %10zu %10s %10s %12.1f\n", "kernel", quads.size() * 2,
+              "-", "-", us);
+  return us;
+}
+
+void RunScene(const char* name, const Scene& scene, bool check_target) {
+  ChunkNeighborhood neighborhood = MakeNeighborhood(scene);
+  std::printf("%s\n", name);
+  RunMode("culled", neighborhood, MesherMode::Culled);
+  RunMode("greedy", neighborhood, MesherMode::Greedy);
+  RunMode("binary", neighborhood, MesherMode::BinaryGreedy);
+  double us = RunKernel(neighborhood);
+  if (check_target) {
+    std::printf("  kernel target %.0f us: %s\n", kTargetMicroseconds,
+                us <= kTargetMicroseconds ? "met" : "missed");
+  }
+  for (int lod = 1; lod < kChunkLodCount; lod++) {
+    char label[16];
+    std::snprintf(label, sizeof(label), "lod %d", lod);
+    RunMode(label, neighborhood, MesherMode::Greedy, lod);
+  }
+  // Every run after the first hits the cache.
+  ChunkMeshCache cache;
+  RunMode("cached", neighborhood, MesherMode::BinaryGreedy, 0, &cache);
+}
+
+// Random blocks at a random density, mixing opaque and transparent types,
+// with some neighbours missing or uniform.
+ChunkNeighborhood MakeRandomNeighborhood(std::mt19937& rng) {
+  static const VoxelType kTypes[] = {VoxelType::Stone, VoxelType::Dirt,
+                                     VoxelType::Glass, VoxelType::Water,
+                                     VoxelType::Leaves};
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  float density = unit(rng);
+  int type_count = 1 + rng() % 5;
+  ChunkNeighborhood neighborhood(ChunkCoord(0));
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        glm::ivec3 offset(dx, dy, dz);
+        int kind = rng() % 8;
+        if (kind == 0 && offset != glm::ivec3(0))
+          continue;
+        Chunk chunk(offset);
+        if (kind == 1) {
+          chunk.Fill(Voxel(kTypes[rng() % type_count]));
+        } else {
+          for (int z = 0; z < kChunkSize; z++)
+            for (int y = 0; y < kChunkSize; y++)
+              for (int x = 0; x < kChunkSize; x++)
+                if (unit(rng) < density)
+                  chunk.Set(x, y, z, Voxel(kTypes[rng() % type_count]));
+        }
+        neighborhood.SetChunk(offset, chunk.Snapshot());
+      }
+    }
+  }
+  return neighborhood;
+}
+
+using FaceCell = std::tuple<int, int, int, int, int, int>;
+
+// Unit faces covered by quads; returns false if two quads overlap.
+bool ExpandQuads(const std::vector<ChunkQuad>& quads,
+                 std::set<FaceCell>& cells) {
+  for (const ChunkQuad& quad : quads) {
+    FaceAxes axes = GetFaceAxes(quad.face);
+    for (int j = 0; j < quad.height; j++) {
+      for (int i = 0; i < quad.width; i++) {
+        glm::ivec3 p(quad.x, quad.y, quad.z);
+        p[axes.u] += i;
+        p[axes.v] += j;
+        FaceCell cell(p.x, p.y, p.z, static_cast<int>(quad.face), quad.block,
+                      quad.ao);
+        if (!cells.insert(cell).second)
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool SameQuads(const std::vector<ChunkQuad>& a,
+               const std::vector<ChunkQuad>& b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (a[i].x != b[i].x || a[i].y != b[i].y || a[i].z != b[i].z ||
+        a[i].width != b[i].width || a[i].height != b[i].height ||
+        a[i].face != b[i].face || a[i].block != b[i].block ||
+        a[i].ao != b[i].ao)
+      return false;
+  }
+  return true;
+}
+
+int Verify(int iterations) {
+  std::mt19937 rng(2024);
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    PaddedChunkVoxels voxels(MakeRandomNeighborhood(rng));
+    std::vector<ChunkQuad> culled, greedy, binary;
+    ChunkMesher::CollectQuads(voxels, culled);
+    ChunkMesher::CollectGreedyQuads(voxels, greedy);
+    BinaryChunkMesher::CollectGreedyQuads(voxels, binary);
+
+    if (!SameQuads(greedy, binary)) {
+      std::printf("iteration %d: binary emitted %zu quads, scalar %zu\n",
+                  iteration, binary.size(), greedy.size());
+      return 1;
+    }
+    std::set<FaceCell> culled_cells, greedy_cells;
+    if (!ExpandQuads(culled, culled_cells) ||
+        !ExpandQuads(greedy, greedy_cells) || culled_cells != greedy_cells) {
+      std::printf("iteration %d: greedy quads do not cover the culled faces\n",
+                  iteration);
+      return 1;
+    }
+  }
+  std::printf("%d random neighbourhoods: all meshers agree\n", iterations);
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::strcmp(argv[1], "--verify") == 0) {
+    return Verify(argc > 2 ? std::atoi(argv[2]) : kDefaultVerifyIterations);
+  }
+
+  std::printf("Chunk mesher benchmark, %d^3 chunk, median of %d runs\n",
+              kChunkSize, kRuns);
+  std::printf("  %-8s %10s %10s %10s %12s\n", "mode", "triangles",
+              "vertices", "bytes", "us/chunk");
+  RunScene("flat terrain", FlatTerrain, true);
+  RunScene("rolling terrain with caves", RollingTerrain, true);
+  RunScene("random noise", RandomNoise, false);
+  return 0;
+}
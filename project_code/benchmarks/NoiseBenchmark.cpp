@@ -0,0 +1,319 @@
+// Evaluates gradient and simplex noise, single octave and fractal, in 2D
+// and 3D with every instruction set this CPU supports, and reports the
+// median time per point; then generates a block of terrain chunks with each,
+// with caves sampled at every voxel and on the coarse lattice, and reports
+// the median time per chunk and how far coarse caves are from full ones.
+//
+// With --verify [iterations], instead evaluates random batches, with odd
+// sizes and coordinates on both sides of zero, with every supported
+// instruction set and checks them against the scalar functions, then
+// checks that every instruction set generates the same terrain with either
+// sampling, and that coarse chunks do not depend on generation order.
+// Exits with a non-zero status on the first mismatch.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "generation/Noise.hpp"
+#include "generation/TerrainGenerator.hpp"
+#include "BenchmarkUtils.hpp"
+
+using namespace GLOO;
+
+namespace {
+const int kRuns = 25;
+const size_t kPoints = 4096;
+const int kDefaultVerifyIterations = 200;
+// The kernels are meant to match the scalar code exactly; this only keeps
+// the check meaningful should a compiler ever reassociate one of them.
+const float kTolerance = 1e-5f;
+const uint64_t kWorldSeed = 1234;
+// Chunks generated per timing run: a 4x4 area, three chunks deep around
+// the surface.
+const int kChunkArea = 4;
+const int kChunkLayers = 3;
+
+struct Points {
+  std::vector<float> x, y, z;
+};
+
+Points MakePoints(std::mt19937& rng, size_t count, float extent) {
+  std::uniform_real_distribution<float> coord(-extent, extent);
+  Points points;
+  for (size_t i = 0; i < count; i++) {
+    points.x.push_back(coord(rng));
+    points.y.push_back(coord(rng));
+    points.z.push_back(coord(rng));
+  }
+  return points;
+}
+
+std::vector<NoiseIsa> GetIsas() {
+  std::vector<NoiseIsa> isas;
+  for (int isa = 0; isa <= static_cast<int>(GetSupportedNoiseIsa()); isa++)
+    isas.push_back(static_cast<NoiseIsa>(isa));
+  return isas;
+}
+
+const char* GetBasisName(NoiseBasis basis) {
+  return basis == NoiseBasis::Simplex ? "simplex" : "gradient";
+}
+
+// Fills out with noise of the given dimension; octaves == 0 means plain
+// noise rather than a one-octave fractal.
+void Evaluate(int dimension, NoiseBasis basis, int octaves,
+              const Points& points, size_t count, float* out) {
+  const uint32_t seed = 42;
+  if (octaves == 0) {
+    if (dimension == 2)
+      EvaluateNoise2D(basis, points.x.data(), points.y.data(), count, seed,
+                      out);
+    else
+      EvaluateNoise3D(basis, points.x.data(), points.y.data(),
+                      points.z.data(), count, seed, out);
+    return;
+  }
+  FractalSettings settings(octaves, 2.0f, 0.5f, basis);
+  if (dimension == 2)
+    EvaluateFractalNoise2D(points.x.data(), points.y.data(), count, seed,
+                           settings, out);
+  else
+    EvaluateFractalNoise3D(points.x.data(), points.y.data(),
+                           points.z.data(), count, seed, settings, out);
+}
+
+using ChunkList = std::vector<std::unique_ptr<Chunk>>;
+
+std::vector<ChunkCoord> GetChunkCoords() {
+  std::vector<ChunkCoord> coords;
+  for (int z = 0; z < kChunkArea; z++)
+    for (int y = -kChunkLayers + 1; y <= 0; y++)
+      for (int x = 0; x < kChunkArea; x++)
+        coords.push_back(ChunkCoord(x, y, z));
+  return coords;
+}
+
+ChunkList GenerateChunks(const TerrainGenerator& generator) {
+  ChunkList chunks;
+  for (const ChunkCoord& coord : GetChunkCoords()) {
+    chunks.emplace_back(new Chunk(coord));
+    generator.Generate(*chunks.back());
+  }
+  return chunks;
+}
+
+TerrainSettings GetSettings(DensitySampling cave_sampling) {
+  TerrainSettings settings;
+  settings.cave_sampling = cave_sampling;
+  return settings;
+}
+
+void RunNoise(const Points& points) {
+  std::printf("  %-22s", "ns/point");
+  for (NoiseIsa isa : GetIsas())
+    std::printf(" %10s", GetNoiseIsaName(isa));
+  std::printf("\n");
+  std::vector<float> out(kPoints);
+  const int kOctaves[] = {0, 4};
+  const NoiseBasis kBases[] = {NoiseBasis::Gradient, NoiseBasis::Simplex};
+  for (int dimension = 2; dimension <= 3; dimension++) {
+    for (NoiseBasis basis : kBases) {
+      for (int octaves : kOctaves) {
+        char label[32];
+        std::snprintf(label, sizeof(label), "%dd %s x%d", dimension,
+                      GetBasisName(basis), octaves == 0 ? 1 : octaves);
+        std::printf("  %-22s", label);
+        for (NoiseIsa isa : GetIsas()) {
+          SetNoiseIsa(isa);
+          double us = MedianMicroseconds(kRuns, [&]() {
+            Evaluate(dimension, basis, octaves, points, kPoints, out.data());
+          });
+          DoNotOptimize(out);
+          std::printf(" %10.2f", us * 1000.0 / kPoints);
+        }
+        std::printf("\n");
+      }
+    }
+  }
+}
+
+bool SameChunks(const ChunkList& a, const ChunkList& b) {
+  for (size_t i = 0; i < a.size(); i++)
+    for (int z = 0; z < kChunkSize; z++)
+      for (int y = 0; y < kChunkSize; y++)
+        for (int x = 0; x < kChunkSize; x++)
+          if (a[i]->Get(x, y, z).getType() != b[i]->Get(x, y, z).getType())
+            return false;
+  return true;
+}
+
+// Air below the soil, which only caves carve.
+size_t CountCaveVoxels(const TerrainGenerator& generator,
+                       const ChunkList& chunks) {
+  int soil_depth = generator.GetSettings().soil_depth;
+  size_t count = 0;
+  for (const auto& chunk : chunks) {
+    glm::ivec3 origin = chunk->GetOrigin();
+    for (int z = 0; z < kChunkSize; z++) {
+      for (int x = 0; x < kChunkSize; x++) {
+        int soil_bottom =
+            generator.GetSurfaceHeight(origin.x + x, origin.z + z) -
+            soil_depth;
+        for (int y = 0; y < kChunkSize && origin.y + y < soil_bottom; y++)
+          if (chunk->Get(x, y, z).getType() == VoxelType::Air)
+            count++;
+      }
+    }
+  }
+  return count;
+}
+
+void RunTerrain() {
+  const DensitySampling kSamplings[] = {DensitySampling::Full,
+                                        DensitySampling::Coarse};
+  const char* kLabels[] = {"terrain us/chunk", "coarse us/chunk"};
+  int chunk_count = kChunkArea * kChunkArea * kChunkLayers;
+  std::vector<double> times[2];
+  for (int i = 0; i < 2; i++) {
+    TerrainGenerator generator(kWorldSeed, GetSettings(kSamplings[i]));
+    for (NoiseIsa isa : GetIsas()) {
+      SetNoiseIsa(isa);
+      times[i].push_back(MedianMicroseconds(5, [&]() {
+        ChunkList chunks = GenerateChunks(generator);
+        DoNotOptimize(chunks);
+      }) / chunk_count);
+    }
+  }
+  std::printf("  %-22s", kLabels[0]);
+  for (double us : times[0])
+    std::printf(" %10.1f", us);
+  std::printf("\n  %-22s", "speedup");
+  for (double us : times[0])
+    std::printf(" %9.2fx", times[0][0] / us);
+  std::printf("\n  %-22s", kLabels[1]);
+  for (double us : times[1])
+    std::printf(" %10.1f", us);
+  std::printf("\n  %-22s", "speedup over full");
+  for (size_t i = 0; i < times[1].size(); i++)
+    std::printf(" %9.2fx", times[0][i] / times[1][i]);
+  std::printf("\n");
+
+  // Quality of coarse caves against full ones, which the ISA does not
+  // change.
+  TerrainGenerator full(kWorldSeed, GetSettings(DensitySampling::Full));
+  TerrainGenerator coarse(kWorldSeed, GetSettings(DensitySampling::Coarse));
+  ChunkList full_chunks = GenerateChunks(full);
+  ChunkList coarse_chunks = GenerateChunks(coarse);
+  size_t differing = 0;
+  for (size_t i = 0; i < full_chunks.size(); i++)
+    for (int z = 0; z < kChunkSize; z++)
+      for (int y = 0; y < kChunkSize; y++)
+        for (int x = 0; x < kChunkSize; x++)
+          if (full_chunks[i]->Get(x, y, z).getType() !=
+              coarse_chunks[i]->Get(x, y, z).getType())
+            differing++;
+  size_t full_caves = CountCaveVoxels(full, full_chunks);
+  size_t coarse_caves = CountCaveVoxels(coarse, coarse_chunks);
+  std::printf("coarse caves: %.2f%% of voxels differ from full sampling "
+              "(%.1f%% of full cave volume); cave volume %.1f%% of full\n",
+              100.0 * differing / (chunk_count * kChunkVolume),
+              full_caves ? 100.0 * differing / full_caves : 0.0,
+              full_caves ? 100.0 * coarse_caves / full_caves : 0.0);
+}
+
+int Verify(int iterations) {
+  std::mt19937 rng(2024);
+  std::uniform_int_distribution<int> size(1, 257);
+  std::uniform_int_distribution<int> octaves(0, 6);
+  std::uniform_real_distribution<float> extent(1.0f, 5000.0f);
+  std::vector<float> expected(257), actual(257);
+  float max_error = 0.0f;
+  for (int iteration = 0; iteration < iterations; iteration++) {
+    size_t count = static_cast<size_t>(size(rng));
+    Points points = MakePoints(rng, count, extent(rng));
+    int dimension = 2 + iteration % 2;
+    NoiseBasis basis = (iteration / 2) % 2 == 0 ? NoiseBasis::Gradient
+                                                : NoiseBasis::Simplex;
+    int octave_count = octaves(rng);
+    SetNoiseIsa(NoiseIsa::Scalar);
+    Evaluate(dimension, basis, octave_count, points, count, expected.data());
+    for (NoiseIsa isa : GetIsas()) {
+      SetNoiseIsa(isa);
+      Evaluate(dimension, basis, octave_count, points, count, actual.data());
+      for (size_t i = 0; i < count; i++) {
+        float error = std::fabs(actual[i] - expected[i]);
+        max_error = std::max(max_error, error);
+        if (!(error <= kTolerance)) {
+          std::printf(
+              "iteration %d: %s %dd %s with %d octaves at point %zu: %g, "
+              "scalar %g\n",
+              iteration, GetNoiseIsaName(isa), dimension,
+              GetBasisName(basis), octave_count, i, actual[i], expected[i]);
+          return 1;
+        }
+      }
+    }
+  }
+  std::printf("%d random batches: every instruction set within %g of "
+              "scalar (max error %g)\n",
+              iterations, kTolerance, max_error);
+
+  const DensitySampling kSamplings[] = {DensitySampling::Full,
+                                        DensitySampling::Coarse};
+  for (DensitySampling sampling : kSamplings) {
+    const char* name = sampling == DensitySampling::Full ? "full" : "coarse";
+    TerrainGenerator generator(kWorldSeed, GetSettings(sampling));
+    SetNoiseIsa(NoiseIsa::Scalar);
+    ChunkList expected_chunks = GenerateChunks(generator);
+    for (NoiseIsa isa : GetIsas()) {
+      SetNoiseIsa(isa);
+      if (!SameChunks(expected_chunks, GenerateChunks(generator))) {
+        std::printf("%s generates different terrain than scalar with %s "
+                    "sampling\n",
+                    GetNoiseIsaName(isa), name);
+        return 1;
+      }
+    }
+    std::printf("every instruction set generates the same terrain with %s "
+                "sampling\n",
+                name);
+  }
+
+  // Each chunk on its own, in reverse order, must match the block.
+  TerrainGenerator coarse(kWorldSeed, GetSettings(DensitySampling::Coarse));
+  ChunkList expected_chunks = GenerateChunks(coarse);
+  std::vector<ChunkCoord> coords = GetChunkCoords();
+  for (size_t i = coords.size(); i-- > 0;) {
+    ChunkList chunk;
+    chunk.emplace_back(new Chunk(coords[i]));
+    coarse.Generate(*chunk.back());
+    ChunkList expected;
+    expected.push_back(std::move(expected_chunks[i]));
+    if (!SameChunks(expected, chunk)) {
+      std::printf("coarse chunk %zu depends on generation order\n", i);
+      return 1;
+    }
+  }
+  std::printf("coarse chunks do not depend on generation order\n");
+  return 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc > 1 && std::strcmp(argv[1], "--verify") == 0) {
+    return Verify(argc > 2 ? std::atoi(argv[2]) : kDefaultVerifyIterations);
+  }
+
+  std::printf("Noise benchmark, batches of %zu points, median of %d runs\n",
+              kPoints, kRuns);
+  std::printf("supported: %s\n", GetNoiseIsaName(GetSupportedNoiseIsa()));
+  std::mt19937 rng(7);
+  RunNoise(MakePoints(rng, kPoints, 1000.0f));
+  RunTerrain();
+  return 0;
+}
@@ -0,0 +1,97 @@
+#include "RangeAllocator.hpp"
+
+#include <iterator>
+#include <stdexcept>
+
+namespace GLOO {
+const size_t RangeAllocator::kInvalidOffset;
+
+RangeAllocator::RangeAllocator(size_t capacity) : capacity_(0), used_(0) {
+  Grow(capacity);
+}
+
+size_t RangeAllocator::Allocate(size_t count) {
+  if (count == 0)
+    throw std::runtime_error("Cannot allocate an empty range!");
+  auto best = free_.end();
+  for (auto it = free_.begin(); it != free_.end(); ++it) {
+    if (it->second >= count &&
+        (best == free_.end() || it->second < best->second)) {
+      best = it;
+      if (best->second == count)
+        break;
+    }
+  }
+  if (best == free_.end())
+    return kInvalidOffset;
+
+  size_t offset = best->first;
+  size_t remaining = best->second - count;
+  free_.erase(best);
+  if (remaining > 0)
+    free_[offset + count] = remaining;
+  live_[offset] = count;
+  used_ += count;
+  return offset;
+}
+
+void RangeAllocator::Free(size_t offset) {
+  auto it = live_.find(offset);
+  if (it == live_.end())
+    throw std::runtime_error("Freeing a range that is not allocated!");
+  size_t count = it->second;
+  live_.erase(it);
+  used_ -= count;
+  AddFreeRange(offset, count);
+}
+
+void RangeAllocator::AddFreeRange(size_t offset, size_t count) {
+  auto next = free_.lower_bound(offset);
+  if (next != free_.end() && offset + count == next->first) {
+    count += next->second;
+    next = free_.erase(next);
+  }
+  if (next != free_.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += count;
+      return;
+    }
+  }
+  free_[offset] = count;
+}
+
+void RangeAllocator::Grow(size_t capacity) {
+  if (capacity <= capacity_)
+    return;
+  size_t old_capacity = capacity_;
+  capacity_ = capacity;
+  AddFreeRange(old_capacity, capacity - old_capacity);
+}
+
+std::vector<RangeMove> RangeAllocator::Compact() {
+  std::vector<RangeMove> moves;
+  moves.reserve(live_.size());
+  std::map<size_t, size_t> packed;
+  size_t cursor = 0;
+  for (const auto& range : live_) {
+    moves.push_back({range.first, cursor, range.second});
+    packed.emplace_hint(packed.end(), cursor, range.second);
+    cursor += range.second;
+  }
+  live_.swap(packed);
+  free_.clear();
+  if (cursor < capacity_)
+    free_[cursor] = capacity_ - cursor;
+  return moves;
+}
+
+size_t RangeAllocator::GetLargestFreeRange() const {
+  size_t largest = 0;
+  for (const auto& range : free_) {
+    if (range.second > largest)
+      largest = range.second;
+  }
+  return largest;
+}
+}  // namespace GLOO
@@ -0,0 +1,62 @@
+#ifndef RANGE_ALLOCATOR_H_
+#define RANGE_ALLOCATOR_H_
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace GLOO {
+// Where Compact() put a live range.
+struct RangeMove {
+  size_t from;
+  size_t to;
+  size_t count;
+};
+
+// Hands out ranges of [0, capacity) in abstract units (bytes, vertices,
+// ...), for sub-allocating one large buffer. Free ranges are kept in an
+// offset-ordered free list, allocation is best fit and freed ranges
+// coalesce with their free neighbours. Nothing here touches the memory
+// being managed; the owner moves data itself when ranges move.
+class RangeAllocator {
+ public:
+  static const size_t kInvalidOffset = static_cast<size_t>(-1);
+
+  explicit RangeAllocator(size_t capacity = 0);
+
+  // Returns the offset of a free range of count units, or kInvalidOffset
+  // if no single free range is large enough.
+  size_t Allocate(size_t count);
+  // offset must come from Allocate and not have been freed since.
+  void Free(size_t offset);
+
+  // Extends the capacity; the new space joins the free list.
+  void Grow(size_t capacity);
+  // Packs the live ranges at the start of the capacity, keeping their
+  // order, and returns where each one went, in offset order (ranges that
+  // stay put included, with from == to).
+  std::vector<RangeMove> Compact();
+
+  size_t GetCapacity() const {
+    return capacity_;
+  }
+  size_t GetUsed() const {
+    return used_;
+  }
+  size_t GetLargestFreeRange() const;
+  size_t GetFreeRangeCount() const {
+    return free_.size();
+  }
+
+ private:
+  void AddFreeRange(size_t offset, size_t count);
+
+  size_t capacity_;
+  size_t used_;
+  // Offset to size, for the free and the allocated ranges.
+  std::map<size_t, size_t> free_;
+  std::map<size_t, size_t> live_;
+};
+}  // namespace GLOO
+
+#endif
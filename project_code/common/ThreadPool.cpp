@@ -0,0 +1,53 @@
+#include "ThreadPool.hpp"
+
+namespace GLOO {
+ThreadPool::ThreadPool(size_t thread_count) : stopping_(false) {
+  if (thread_count == 0) {
+    size_t hardware = std::thread::hardware_concurrency();
+    thread_count = hardware > 1 ? hardware - 1 : 1;
+  }
+  workers_.reserve(thread_count);
+  for (size_t i = 0; i < thread_count; i++)
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    tasks_.clear();
+  }
+  task_available_.notify_all();
+  for (std::thread& worker : workers_)
+    worker.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+  }
+  task_available_.notify_one();
+}
+
+size_t ThreadPool::GetQueuedCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return tasks_.size();
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      task_available_.wait(lock,
+                           [this] { return stopping_ || !tasks_.empty(); });
+      if (stopping_)
+        return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+}  // namespace GLOO
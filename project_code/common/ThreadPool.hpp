@@ -0,0 +1,45 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace GLOO {
+// Fixed set of worker threads running submitted tasks in FIFO order. Tasks
+// still queued when the pool is destroyed are dropped; running ones are
+// waited for, so a task must not block on anything the destroying thread
+// holds.
+class ThreadPool {
+ public:
+  // A thread count of 0 picks one worker per hardware thread, minus one for
+  // the render thread, and at least one.
+  explicit ThreadPool(size_t thread_count = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  void operator=(const ThreadPool&) = delete;
+
+  void Submit(std::function<void()> task);
+
+  size_t GetThreadCount() const {
+    return workers_.size();
+  }
+  // Tasks waiting for a worker; does not count running ones.
+  size_t GetQueuedCount() const;
+
+ private:
+  void WorkerLoop();
+
+  mutable std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_;
+  std::vector<std::thread> workers_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,49 @@
+#include "BlockRegistry.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+namespace GLOO {
+namespace {
+// Compile-time check that kBuiltinBlocks is indexed by VoxelType.
+constexpr bool BuiltinTableMatches(size_t i) {
+  return i == kBuiltinBlockCount ||
+         (static_cast<size_t>(kBuiltinBlocks[i].type) == i &&
+          BuiltinTableMatches(i + 1));
+}
+static_assert(BuiltinTableMatches(0),
+              "kBuiltinBlocks must be ordered like VoxelType!");
+static_assert(!IsBuiltinOpaque(VoxelType::Air), "Air must not be opaque!");
+}  // namespace
+
+BlockRegistry::BlockRegistry() {
+  for (size_t i = 0; i < kBuiltinBlockCount; i++)
+    Add(kBuiltinBlocks[i]);
+}
+
+void BlockRegistry::Add(const BlockDesc& desc) {
+  names_.push_back(desc.name);
+  opaque_.push_back(desc.opaque ? 1 : 0);
+  solid_.push_back(desc.solid ? 1 : 0);
+  light_emission_.push_back(desc.light_emission);
+  face_layers_.insert(face_layers_.end(), desc.face_layers,
+                      desc.face_layers + kBlockFaceCount);
+}
+
+BlockId BlockRegistry::Register(const BlockDesc& desc) {
+  if (names_.size() > std::numeric_limits<BlockId>::max()) {
+    throw std::runtime_error("Block registry is out of block IDs!");
+  }
+  BlockId id = static_cast<BlockId>(names_.size());
+  Add(desc);
+  return id;
+}
+
+BlockId BlockRegistry::FindByName(const std::string& name) const {
+  for (size_t i = 0; i < names_.size(); i++) {
+    if (names_[i] == name)
+      return static_cast<BlockId>(i);
+  }
+  throw std::runtime_error("Unknown block " + name + "!");
+}
+}  // namespace GLOO
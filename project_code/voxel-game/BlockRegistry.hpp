@@ -0,0 +1,162 @@
+#ifndef BLOCK_REGISTRY_H_
+#define BLOCK_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Voxel.hpp"
+
+namespace GLOO {
+// Face order used by every per-face table (texture layers, mesher
+// directions, ...).
+enum class BlockFace : uint8_t { PosX, NegX, PosY, NegY, PosZ, NegZ };
+const int kBlockFaceCount = 6;
+
+// Texture layers referenced by the built-in blocks.
+enum BlockLayer : uint16_t {
+  kLayerNone = 0,
+  kLayerDirt,
+  kLayerStone,
+  kLayerGrassTop,
+  kLayerGrassSide,
+  kLayerSand,
+  kLayerWoodSide,
+  kLayerWoodTop,
+  kLayerLeaves,
+  kLayerWater,
+  kLayerGlass,
+  kLayerLamp,
+  kBuiltinLayerCount
+};
+
+struct BlockDesc {
+  VoxelType type;
+  const char* name;
+  // Opaque blocks hide the faces of their neighbours.
+  bool opaque;
+  // Solid blocks take part in collision.
+  bool solid;
+  // Emitted light level in [0, 15].
+  uint8_t light_emission;
+  // Texture layer per face, indexed by BlockFace.
+  uint16_t face_layers[kBlockFaceCount];
+};
+
+// Built-in blocks, indexed by VoxelType. Everything here is a compile-time
+// constant, so code that only deals with built-in types can fold the lookups
+// away entirely.
+constexpr BlockDesc kBuiltinBlocks[] = {
+    {VoxelType::Air, "air", false, false, 0, {0, 0, 0, 0, 0, 0}},
+    {VoxelType::Dirt, "dirt", true, true, 0,
+     {kLayerDirt, kLayerDirt, kLayerDirt, kLayerDirt, kLayerDirt, kLayerDirt}},
+    {VoxelType::Stone, "stone", true, true, 0,
+     {kLayerStone, kLayerStone, kLayerStone, kLayerStone, kLayerStone,
+      kLayerStone}},
+    {VoxelType::Grass, "grass", true, true, 0,
+     {kLayerGrassSide, kLayerGrassSide, kLayerGrassTop, kLayerDirt,
+      kLayerGrassSide, kLayerGrassSide}},
+    {VoxelType::Sand, "sand", true, true, 0,
+     {kLayerSand, kLayerSand, kLayerSand, kLayerSand, kLayerSand, kLayerSand}},
+    {VoxelType::Wood, "wood", true, true, 0,
+     {kLayerWoodSide, kLayerWoodSide, kLayerWoodTop, kLayerWoodTop,
+      kLayerWoodSide, kLayerWoodSide}},
+    {VoxelType::Leaves, "leaves", false, true, 0,
+     {kLayerLeaves, kLayerLeaves, kLayerLeaves, kLayerLeaves, kLayerLeaves,
+      kLayerLeaves}},
+    {VoxelType::Water, "water", false, false, 0,
+     {kLayerWater, kLayerWater, kLayerWater, kLayerWater, kLayerWater,
+      kLayerWater}},
+    {VoxelType::Glass, "glass", false, true, 0,
+     {kLayerGlass, kLayerGlass, kLayerGlass, kLayerGlass, kLayerGlass,
+      kLayerGlass}},
+    {VoxelType::Lamp, "lamp", true, true, 15,
+     {kLayerLamp, kLayerLamp, kLayerLamp, kLayerLamp, kLayerLamp, kLayerLamp}},
+};
+
+const size_t kBuiltinBlockCount =
+    sizeof(kBuiltinBlocks) / sizeof(kBuiltinBlocks[0]);
+
+constexpr bool IsBuiltinOpaque(VoxelType type) {
+  return kBuiltinBlocks[static_cast<BlockId>(type)].opaque;
+}
+constexpr bool IsBuiltinSolid(VoxelType type) {
+  return kBuiltinBlocks[static_cast<BlockId>(type)].solid;
+}
+constexpr uint8_t GetBuiltinLightEmission(VoxelType type) {
+  return kBuiltinBlocks[static_cast<BlockId>(type)].light_emission;
+}
+constexpr uint16_t GetBuiltinFaceLayer(VoxelType type, BlockFace face) {
+  return kBuiltinBlocks[static_cast<BlockId>(type)]
+      .face_layers[static_cast<int>(face)];
+}
+
+// Maps block IDs to flat property arrays. The built-in blocks occupy the IDs
+// of their VoxelType; further blocks can be registered at startup, before any
+// worker thread reads the tables. Lookups are plain array indexing so inner
+// loops (meshing, lighting, physics) can use them without branching on the
+// type.
+class BlockRegistry {
+ public:
+  // Singleton design pattern, like InputManager.
+  static BlockRegistry& GetInstance() {
+    static BlockRegistry _instance;
+    return _instance;
+  }
+
+  BlockRegistry(const BlockRegistry&) = delete;
+  void operator=(const BlockRegistry&) = delete;
+
+  // Adds a block and returns its ID. desc.type is ignored.
+  BlockId Register(const BlockDesc& desc);
+  // Returns the ID of the block called name, or throws if there is none.
+  BlockId FindByName(const std::string& name) const;
+
+  size_t GetBlockCount() const {
+    return names_.size();
+  }
+  const std::string& GetName(BlockId id) const {
+    return names_[id];
+  }
+  bool IsOpaque(BlockId id) const {
+    return opaque_[id] != 0;
+  }
+  bool IsSolid(BlockId id) const {
+    return solid_[id] != 0;
+  }
+  uint8_t GetLightEmission(BlockId id) const {
+    return light_emission_[id];
+  }
+  uint16_t GetFaceLayer(BlockId id, BlockFace face) const {
+    return face_layers_[id * kBlockFaceCount + static_cast<int>(face)];
+  }
+
+  // Raw tables for hot loops. Each holds GetBlockCount() entries (six per
+  // block for the face layers); values are 0 or 1 for the boolean tables.
+  const uint8_t* GetOpaqueTable() const {
+    return opaque_.data();
+  }
+  const uint8_t* GetSolidTable() const {
+    return solid_.data();
+  }
+  const uint8_t* GetLightEmissionTable() const {
+    return light_emission_.data();
+  }
+  const uint16_t* GetFaceLayerTable() const {
+    return face_layers_.data();
+  }
+
+ private:
+  BlockRegistry();
+  void Add(const BlockDesc& desc);
+
+  std::vector<std::string> names_;
+  std::vector<uint8_t> opaque_;
+  std::vector<uint8_t> solid_;
+  std::vector<uint8_t> light_emission_;
+  std::vector<uint16_t> face_layers_;
+};
+}  // namespace GLOO
+
+#endif
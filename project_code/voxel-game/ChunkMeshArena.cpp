@@ -0,0 +1,118 @@
+#include "ChunkMeshArena.hpp"
+
+#include <stdexcept>
+
+namespace GLOO {
+namespace {
+// New capacity for a reallocation that must leave room for extra more
+// units: packing frees all the fragmented space, so the buffer only grows
+// when live ranges plus extra exceed it.
+size_t GrownCapacity(const RangeAllocator& allocator, size_t extra) {
+  size_t capacity = allocator.GetCapacity();
+  while (capacity < allocator.GetUsed() + extra)
+    capacity *= 2;
+  return capacity;
+}
+
+// Packs the allocator and returns the GPU copies that carry the live ranges
+// over, merging ranges that were already adjacent.
+std::vector<BufferRangeCopy> PackRanges(RangeAllocator& allocator,
+                                        std::unordered_map<size_t, size_t>&
+                                            new_offsets) {
+  std::vector<BufferRangeCopy> copies;
+  for (const RangeMove& move : allocator.Compact()) {
+    new_offsets[move.from] = move.to;
+    if (!copies.empty()) {
+      BufferRangeCopy& last = copies.back();
+      if (last.source_first + last.count == move.from &&
+          last.target_first + last.count == move.to) {
+        last.count += move.count;
+        continue;
+      }
+    }
+    copies.push_back({move.from, move.to, move.count});
+  }
+  return copies;
+}
+}  // namespace
+
+ChunkMeshArena::ChunkMeshArena(const VertexLayout& layout,
+                               std::shared_ptr<QuadIndexBuffer> quad_indices,
+                               size_t vertex_capacity)
+    : vertex_obj_(std::make_shared<VertexObject>()),
+      quad_indices_(std::move(quad_indices)), vertex_ranges_(vertex_capacity),
+      layout_version_(0), reallocations_(0) {
+  if (vertex_capacity == 0)
+    throw std::runtime_error("Chunk mesh arena needs a non-zero capacity!");
+  VertexArray& vertex_array = vertex_obj_->GetVertexArray();
+  vertex_array.CreateCustomBuffer(layout);
+  vertex_array.ReallocateCustomVertices(vertex_capacity, {});
+  vertex_array.UseQuadIndices(quad_indices_);
+  vertex_array.SetDrawMode(DrawMode::Triangles);
+}
+
+const ChunkMeshRange& ChunkMeshArena::Upload(const ChunkCoord& coord,
+                                             const ChunkMeshData& mesh) {
+  if (mesh.IsEmpty())
+    throw std::runtime_error("Cannot upload an empty chunk mesh!");
+  Remove(coord);
+
+  size_t vertex_count = mesh.vertices.size();
+  size_t first_vertex = vertex_ranges_.Allocate(vertex_count);
+  if (first_vertex == RangeAllocator::kInvalidOffset) {
+    ReallocateVertices(vertex_count);
+    first_vertex = vertex_ranges_.Allocate(vertex_count);
+  }
+  vertex_obj_->GetVertexArray().UpdateCustomVertexRange(
+      first_vertex, mesh.vertices.data(), vertex_count);
+  quad_indices_->Reserve(mesh.GetQuadCount());
+
+  ChunkMeshRange& range = chunks_[coord];
+  range = {first_vertex, vertex_count};
+  return range;
+}
+
+void ChunkMeshArena::Remove(const ChunkCoord& coord) {
+  auto it = chunks_.find(coord);
+  if (it == chunks_.end())
+    return;
+  vertex_ranges_.Free(it->second.first_vertex);
+  chunks_.erase(it);
+}
+
+void ChunkMeshArena::Clear() {
+  for (const auto& entry : chunks_)
+    vertex_ranges_.Free(entry.second.first_vertex);
+  chunks_.clear();
+}
+
+const ChunkMeshRange* ChunkMeshArena::Find(const ChunkCoord& coord) const {
+  auto it = chunks_.find(coord);
+  return it == chunks_.end() ? nullptr : &it->second;
+}
+
+void ChunkMeshArena::Defragment() {
+  ReallocateVertices(0);
+}
+
+void ChunkMeshArena::ReallocateVertices(size_t extra) {
+  size_t capacity = GrownCapacity(vertex_ranges_, extra);
+  std::unordered_map<size_t, size_t> new_offsets;
+  std::vector<BufferRangeCopy> copies =
+      PackRanges(vertex_ranges_, new_offsets);
+  vertex_ranges_.Grow(capacity);
+  vertex_obj_->GetVertexArray().ReallocateCustomVertices(capacity, copies);
+  for (auto& entry : chunks_)
+    entry.second.first_vertex = new_offsets.at(entry.second.first_vertex);
+  layout_version_++;
+  reallocations_++;
+}
+
+ChunkMeshArenaStats ChunkMeshArena::GetStats() const {
+  ChunkMeshArenaStats stats;
+  stats.vertex_capacity = vertex_ranges_.GetCapacity();
+  stats.vertices_used = vertex_ranges_.GetUsed();
+  stats.reallocations = reallocations_;
+  return stats;
+}
+}  // namespace GLOO
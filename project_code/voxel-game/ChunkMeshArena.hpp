@@ -0,0 +1,72 @@
+#ifndef CHUNK_MESH_ARENA_H_
+#define CHUNK_MESH_ARENA_H_
+
+#include <unordered_map>
+
+#include "gloo/VertexObject.hpp"
+
+#include "RangeAllocator.hpp"
+
+#include "meshing/ChunkMesher.hpp"
+
+namespace GLOO {
+// Where a chunk's mesh lives in the arena's vertex buffer.
+struct ChunkMeshRange {
+  size_t first_vertex;
+  size_t vertex_count;
+};
+
+struct ChunkMeshArenaStats {
+  size_t vertex_capacity = 0;
+  size_t vertices_used = 0;
+  // Buffer moves so far, whether to compact or to grow.
+  size_t reallocations = 0;
+};
+
+// All chunk meshes in one large vertex buffer behind a single VAO. Each
+// chunk gets a vertex range from a free-list allocator and is drawn from
+// the shared quad index buffer with its first vertex as base vertex, so
+// uploads never rewrite other chunks and chunks need no indices of their
+// own.
+//
+// When a range does not fit, the buffer is reallocated: live ranges are
+// packed on the GPU into a fresh buffer, doubled in size only if packing
+// alone cannot make room. Packing moves ranges, which bumps the layout
+// version; draw ranges taken before then must be looked up again.
+class ChunkMeshArena {
+ public:
+  ChunkMeshArena(const VertexLayout& layout,
+                 std::shared_ptr<QuadIndexBuffer> quad_indices,
+                 size_t vertex_capacity);
+
+  // Replaces the chunk's mesh, which must not be empty.
+  const ChunkMeshRange& Upload(const ChunkCoord& coord,
+                               const ChunkMeshData& mesh);
+  void Remove(const ChunkCoord& coord);
+  void Clear();
+  const ChunkMeshRange* Find(const ChunkCoord& coord) const;
+
+  // Packs the buffer now, e.g. after a lot of unloading.
+  void Defragment();
+
+  std::shared_ptr<VertexObject> GetVertexObject() const {
+    return vertex_obj_;
+  }
+  size_t GetLayoutVersion() const {
+    return layout_version_;
+  }
+  ChunkMeshArenaStats GetStats() const;
+
+ private:
+  void ReallocateVertices(size_t extra);
+
+  std::shared_ptr<VertexObject> vertex_obj_;
+  std::shared_ptr<QuadIndexBuffer> quad_indices_;
+  RangeAllocator vertex_ranges_;
+  std::unordered_map<ChunkCoord, ChunkMeshRange, ChunkCoordHash> chunks_;
+  size_t layout_version_;
+  size_t reallocations_;
+};
+}  // namespace GLOO
+
+#endif
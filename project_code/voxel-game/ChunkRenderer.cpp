@@ -0,0 +1,104 @@
+#include "ChunkRenderer.hpp"
+
+#include "gloo/components/RenderingComponent.hpp"
+#include "gloo/components/ShadingComponent.hpp"
+#include "gloo/components/MaterialComponent.hpp"
+
+namespace GLOO {
+namespace {
+// Flat colors standing in for the block textures, indexed by BlockLayer.
+const glm::vec3 kLayerColors[kBuiltinLayerCount] = {
+    glm::vec3(1.0f, 0.0f, 1.0f),     // kLayerNone
+    glm::vec3(0.45f, 0.32f, 0.2f),   // kLayerDirt
+    glm::vec3(0.5f, 0.5f, 0.5f),     // kLayerStone
+    glm::vec3(0.3f, 0.6f, 0.2f),     // kLayerGrassTop
+    glm::vec3(0.4f, 0.45f, 0.22f),   // kLayerGrassSide
+    glm::vec3(0.86f, 0.8f, 0.55f),   // kLayerSand
+    glm::vec3(0.4f, 0.28f, 0.15f),   // kLayerWoodSide
+    glm::vec3(0.6f, 0.48f, 0.3f),    // kLayerWoodTop
+    glm::vec3(0.2f, 0.45f, 0.15f),   // kLayerLeaves
+    glm::vec3(0.2f, 0.35f, 0.8f),    // kLayerWater
+    glm::vec3(0.75f, 0.85f, 0.9f),   // kLayerGlass
+    glm::vec3(1.0f, 0.9f, 0.6f),     // kLayerLamp
+};
+
+// Starting arena size, enough for a few hundred terrain chunks; the arena
+// doubles when it runs out.
+const size_t kInitialArenaVertices = 1 << 18;
+}  // namespace
+
+ChunkRenderer::ChunkRenderer(SceneNode& parent)
+    : parent_(parent),
+      shader_(std::make_shared<VoxelShader>()),
+      material_(std::make_shared<Material>(glm::vec3(0.5f), glm::vec3(0.5f),
+                                           glm::vec3(0.1f), 16.0f)),
+      arena_(VoxelShader::GetVertexLayout(),
+             std::make_shared<QuadIndexBuffer>(QuadIndexBuffer::kMaxShortQuads),
+             kInitialArenaVertices),
+      arena_layout_version_(arena_.GetLayoutVersion()) {
+  shader_->SetLayerColors(std::vector<glm::vec3>(
+      kLayerColors, kLayerColors + kBuiltinLayerCount));
+}
+
+ChunkRenderer::~ChunkRenderer() {
+  Clear();
+}
+
+void ChunkRenderer::UpdateChunk(const ChunkCoord& coord, ChunkMeshData mesh) {
+  if (mesh.IsEmpty()) {
+    RemoveChunk(coord);
+    return;
+  }
+
+  const ChunkMeshRange& range = arena_.Upload(coord, mesh);
+  if (arena_.GetLayoutVersion() != arena_layout_version_)
+    SyncDrawRanges();
+
+  auto it = nodes_.find(coord);
+  if (it != nodes_.end()) {
+    SetDrawRange(*it->second, range);
+    return;
+  }
+
+  auto node = make_unique<SceneNode>();
+  node->GetTransform().SetPosition(glm::vec3(ChunkOrigin(coord)));
+  node->CreateComponent<ShadingComponent>(shader_);
+  node->CreateComponent<RenderingComponent>(arena_.GetVertexObject());
+  node->CreateComponent<MaterialComponent>(material_);
+  SetDrawRange(*node, range);
+  nodes_[coord] = node.get();
+  parent_.AddChild(std::move(node));
+}
+
+void ChunkRenderer::SetDrawRange(SceneNode& node,
+                                 const ChunkMeshRange& range) {
+  node.GetComponentPtr<RenderingComponent>()->SetDrawRange(
+      0, static_cast<int>(range.vertex_count / 4 * 6),
+      static_cast<int>(range.first_vertex));
+}
+
+void ChunkRenderer::SyncDrawRanges() {
+  for (auto& entry : nodes_) {
+    const ChunkMeshRange* range = arena_.Find(entry.first);
+    if (range != nullptr)
+      SetDrawRange(*entry.second, *range);
+  }
+  arena_layout_version_ = arena_.GetLayoutVersion();
+}
+
+void ChunkRenderer::RemoveChunk(const ChunkCoord& coord) {
+  auto it = nodes_.find(coord);
+  if (it == nodes_.end())
+    return;
+  arena_.Remove(coord);
+  parent_.RemoveChild(it->second);
+  nodes_.erase(it);
+}
+
+void ChunkRenderer::Clear() {
+  for (auto& entry : nodes_)
+    parent_.RemoveChild(entry.second);
+  nodes_.clear();
+  arena_.Clear();
+}
+}  // namespace GLOO
@@ -0,0 +1,51 @@
+#ifndef CHUNK_RENDERER_H_
+#define CHUNK_RENDERER_H_
+
+#include <unordered_map>
+
+#include "gloo/SceneNode.hpp"
+#include "gloo/Material.hpp"
+#include "gloo/shaders/VoxelShader.hpp"
+
+#include "ChunkMeshArena.hpp"
+#include "meshing/ChunkMesher.hpp"
+
+namespace GLOO {
+// GPU side of the chunk meshes: one scene node per non-empty chunk, placed
+// at the chunk origin under a parent node, so the model matrix carries the
+// chunk origin into each draw. The meshes themselves share one
+// ChunkMeshArena, and each node draws its range of it, so a remesh only
+// rewrites the chunk that changed and every chunk uses the same VAO.
+// Vertices stay packed on the GPU and are decoded by VoxelShader.
+class ChunkRenderer {
+ public:
+  explicit ChunkRenderer(SceneNode& parent);
+  ~ChunkRenderer();
+
+  // Replaces the chunk's mesh; an empty mesh drops the chunk's node.
+  void UpdateChunk(const ChunkCoord& coord, ChunkMeshData mesh);
+  void RemoveChunk(const ChunkCoord& coord);
+  void Clear();
+
+  size_t GetChunkCount() const {
+    return nodes_.size();
+  }
+  ChunkMeshArenaStats GetArenaStats() const {
+    return arena_.GetStats();
+  }
+
+ private:
+  static void SetDrawRange(SceneNode& node, const ChunkMeshRange& range);
+  // Re-reads every node's range after the arena moved them.
+  void SyncDrawRanges();
+
+  SceneNode& parent_;
+  std::shared_ptr<VoxelShader> shader_;
+  std::shared_ptr<Material> material_;
+  ChunkMeshArena arena_;
+  size_t arena_layout_version_;
+  std::unordered_map<ChunkCoord, SceneNode*, ChunkCoordHash> nodes_;
+};
+}  // namespace GLOO
+
+#endif
@@ -3,12 +3,27 @@
 #ifndef VOXEL_H
 #define VOXEL_H
 
+#include <cstdint>
+
 namespace GLOO{
+    // Compact block ID; see BlockRegistry for the properties behind each ID.
+    using BlockId = uint16_t;
+
     // VoxelType can be an enum representing different types of voxels (e.g., air, dirt, stone)
-    enum class VoxelType {
+    // The values double as BlockIds of the built-in blocks, so the order
+    // must match kBuiltinBlocks in BlockRegistry.hpp. Blocks registered at
+    // runtime use IDs past the last built-in one.
+    enum class VoxelType : BlockId {
         Air,
         Dirt,
         Stone,
+        Grass,
+        Sand,
+        Wood,
+        Leaves,
+        Water,
+        Glass,
+        Lamp,
         // ... other types
     };
 
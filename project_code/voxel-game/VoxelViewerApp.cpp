@@ -21,6 +21,8 @@
 
 #include "PlayerNode.hpp"
 #include "world.hpp"
+#include "WorldNode.hpp"
+#include "generation/TerrainGenerator.hpp"
 
 namespace {
 void SetAmbientToDiffuse(GLOO::MeshData& mesh_data) {
@@ -46,10 +48,16 @@ void VoxelViewerApp::SetupScene() {
 
   // Creates a player node that can be controlled by the user.
   auto camera_node = make_unique<PlayerNode>(50.0f, 1.0f, 4.0f, 1.0f);
-  camera_node->GetTransform().SetPosition(glm::vec3(0.0f, 2.0f, 0.0f));
+  // Start just above the ground at the origin.
+  float spawn_height =
+      TerrainGenerator(static_cast<uint64_t>(seed_)).GetSurfaceHeight(0, 0) +
+      3.0f;
+  camera_node->GetTransform().SetPosition(
+      glm::vec3(0.0f, spawn_height, 0.0f));
   camera_node->GetTransform().SetRotation(glm::vec3(0.0f, 1.0f, 0.0f), kPi / 2);
   camera_node->Calibrate();
   scene_->ActivateCamera(camera_node->GetComponentPtr<CameraComponent>());
+  const SceneNode& player = *camera_node;
   root.AddChild(std::move(camera_node));
 
   // Add in the ambient light so the shadowed areas won't be completely black.
@@ -81,8 +89,14 @@ void VoxelViewerApp::SetupScene() {
   //    mesh_node->CreateComponent<MaterialComponent>(mesh.material);
   //    root.AddChild(std::move(mesh_node));
   //}
-    World world(0);
-    world.Render(root);
+  // The world streams chunks in around the player as it moves.
+  auto world_node = make_unique<WorldNode>(make_unique<World>(seed_), player);
+  world_node->SetMesherMode(greedy_meshing_ ? MesherMode::BinaryGreedy : MesherMode::Culled);
+  ChunkLodSettings lod_settings;
+  lod_settings.enabled = lod_meshing_;
+  world_node->SetLodSettings(lod_settings);
+  world_node_ = world_node.get();
+  root.AddChild(std::move(world_node));
 
 }
 
@@ -95,10 +109,15 @@ void VoxelViewerApp::DrawGUI() {
   ImGui::Text("Use the mouse to rotate the camera.");
   ImGui::InputInt("Seed", &seed_);
   ImGui::Checkbox("Enable Shadows", &enable_shadows_);
-  if (ImGui::Button("Regenerate")) {
-	srand(seed_);
-	SetupScene();
+  if (ImGui::Checkbox("Greedy Meshing", &greedy_meshing_) && world_node_ != nullptr)
+    world_node_->SetMesherMode(greedy_meshing_ ? MesherMode::BinaryGreedy : MesherMode::Culled);
+  if (ImGui::Checkbox("Level of Detail", &lod_meshing_) && world_node_ != nullptr) {
+    ChunkLodSettings lod_settings = world_node_->GetLodSettings();
+    lod_settings.enabled = lod_meshing_;
+    world_node_->SetLodSettings(lod_settings);
   }
+  if (ImGui::Button("Regenerate") && world_node_ != nullptr)
+    world_node_->SetWorld(make_unique<World>(seed_));
   ImGui::End();
 }
 }  // namespace GLOO
@@ -3,6 +3,8 @@
 
 #include "gloo/Application.hpp"
 
+#include "WorldNode.hpp"
+
 namespace GLOO {
 class VoxelViewerApp : public Application {
  public:
@@ -13,6 +15,9 @@ class VoxelViewerApp : public Application {
 private:
 	int seed_ = 0;
 	bool enable_shadows_ = false;
+	bool greedy_meshing_ = true;
+	bool lod_meshing_ = true;
+	WorldNode* world_node_ = nullptr;
 	
 };
 }  // namespace GLOO
@@ -0,0 +1,148 @@
+#include "WorldNode.hpp"
+
+namespace GLOO {
+WorldNode::WorldNode(std::unique_ptr<World> world, const SceneNode& viewer)
+    : world_(std::move(world)), viewer_(viewer), renderer_(*this),
+      mesher_mode_(MesherMode::BinaryGreedy), lod_center_(0),
+      lods_valid_(false), mesh_queue_(worker_pool_, &mesh_cache_) {
+  world_->SetGenerationPool(&worker_pool_);
+}
+
+void WorldNode::SetWorld(std::unique_ptr<World> world) {
+  mesh_queue_.CancelAll();
+  renderer_.Clear();
+  chunk_lods_.clear();
+  lods_valid_ = false;
+  world_ = std::move(world);
+  world_->SetGenerationPool(&worker_pool_);
+}
+
+void WorldNode::SetMesherMode(MesherMode mode) {
+  if (mode == mesher_mode_)
+    return;
+  mesher_mode_ = mode;
+  for (const auto& entry : world_->GetChunks())
+    RemeshChunk(entry.first);
+}
+
+void WorldNode::Update(double delta_time) {
+  const Transform& transform = viewer_.GetTransform();
+  world_->Update(transform.GetWorldPosition(),
+                 transform.GetForwardDirection());
+
+  ChunkSet remesh;
+  for (const ChunkCoord& coord : world_->TakeResidencyChanges())
+    QueueWithNeighbors(coord, remesh);
+  UpdateLods(transform.GetWorldPosition(), remesh);
+  ChunkSet edited;
+  if (world_->HasDirtyChunks()) {
+    for (const ChunkEdit& edit : world_->TakeDirtyChunks())
+      QueueEdit(edit, edited);
+  }
+
+  bool immediate = edited.size() <= kMaxImmediateRemeshes;
+  for (const ChunkCoord& coord : edited) {
+    remesh.erase(coord);
+    RemeshChunk(coord, immediate);
+  }
+  for (const ChunkCoord& coord : remesh)
+    RemeshChunk(coord);
+
+  UploadMeshes();
+}
+
+void WorldNode::QueueWithNeighbors(const ChunkCoord& coord,
+                                   ChunkSet& queue) const {
+  ChunkDirtyRegion whole_chunk;
+  whole_chunk.Include(glm::ivec3(0), glm::ivec3(kChunkSize));
+  QueueEdit({coord, whole_chunk}, queue);
+}
+
+void WorldNode::QueueEdit(const ChunkEdit& edit, ChunkSet& queue) const {
+  queue.insert(edit.coord);
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        glm::ivec3 offset(dx, dy, dz);
+        if (offset == glm::ivec3(0))
+          continue;
+        ChunkCoord neighbor = edit.coord + offset;
+        // Unloaded neighbours have no mesh to refresh.
+        if (world_->GetChunk(neighbor) == nullptr)
+          continue;
+        // The neighbour sees the edit only if the box reaches every border
+        // it lies across, as deep as the neighbour reads: one layer at full
+        // detail, one coarse cell of its level otherwise (see
+        // LodChunkVoxels).
+        int depth = 1 << SelectLod(neighbor);
+        bool touches = true;
+        for (int axis = 0; axis < 3; axis++) {
+          if (offset[axis] != 0)
+            touches &=
+                edit.region.TouchesBorder(axis, offset[axis] > 0, depth);
+        }
+        if (touches)
+          queue.insert(neighbor);
+      }
+    }
+  }
+}
+
+void WorldNode::UpdateLods(const glm::vec3& viewer_position,
+                           ChunkSet& queue) {
+  ChunkCoord center =
+      WorldToChunkCoord(glm::ivec3(glm::floor(viewer_position)));
+  if (lods_valid_ && center == lod_center_)
+    return;
+  lod_center_ = center;
+  lods_valid_ = true;
+  for (const auto& entry : chunk_lods_) {
+    if (SelectLod(entry.first) != entry.second)
+      queue.insert(entry.first);
+  }
+}
+
+int WorldNode::SelectLod(const ChunkCoord& coord) const {
+  if (!lod_settings_.enabled)
+    return 0;
+  float distance = glm::length(glm::vec3(coord - lod_center_));
+  int lod = 0;
+  while (lod + 1 < kChunkLodCount &&
+         distance >= lod_settings_.level_distances[lod])
+    lod++;
+  return lod;
+}
+
+void WorldNode::RemeshChunk(const ChunkCoord& coord, bool immediate) {
+  if (world_->GetChunk(coord) == nullptr) {
+    mesh_queue_.Cancel(coord);
+    renderer_.RemoveChunk(coord);
+    chunk_lods_.erase(coord);
+    return;
+  }
+  ChunkNeighborhood neighborhood = world_->SnapshotNeighborhood(coord);
+  // Buried and all-air chunks are common and need no worker round trip.
+  if (ChunkMesher::IsTriviallyEmpty(neighborhood)) {
+    mesh_queue_.Cancel(coord);
+    renderer_.RemoveChunk(coord);
+    chunk_lods_.erase(coord);
+    return;
+  }
+  int lod = SelectLod(coord);
+  chunk_lods_[coord] = lod;
+  if (immediate) {
+    // Retire any request still in flight, or its older mesh would land on
+    // top of this one.
+    mesh_queue_.Cancel(coord);
+    renderer_.UpdateChunk(coord, ChunkMesher::Mesh(neighborhood, mesher_mode_,
+                                                   lod, &mesh_cache_));
+    return;
+  }
+  mesh_queue_.Request(coord, std::move(neighborhood), mesher_mode_, lod);
+}
+
+void WorldNode::UploadMeshes() {
+  for (ChunkMeshResult& result : mesh_queue_.TakeResults(upload_budget_))
+    renderer_.UpdateChunk(result.coord, std::move(result.mesh));
+}
+}  // namespace GLOO
@@ -0,0 +1,127 @@
+#ifndef WORLD_NODE_H_
+#define WORLD_NODE_H_
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "gloo/SceneNode.hpp"
+
+#include "ThreadPool.hpp"
+
+#include "ChunkRenderer.hpp"
+#include "meshing/ChunkMeshQueue.hpp"
+#include "world.hpp"
+
+namespace GLOO {
+// Distances from the viewer, in chunks, at which chunks switch to coarser
+// levels of detail: level i + 1 starts at level_distances[i].
+struct ChunkLodSettings {
+  bool enabled = true;
+  float level_distances[kChunkLodCount - 1] = {2.5f, 4.5f, 6.5f};
+};
+
+// Owns the world and keeps it streaming around a viewer node (usually the
+// player). Missing chunks are generated on a worker pool, nearest to the
+// viewer first (see ChunkGenerationPipeline). A chunk is remeshed when it
+// loads or unloads, together with its 26 neighbours, whose border faces and
+// AO depend on it. That meshing runs on the same pool; each frame uploads
+// the finished meshes that fit the upload budget, so streaming in a large
+// area spreads over several frames instead of stalling one.
+//
+// Edits are coalesced by the world into one dirty box per chunk and frame.
+// An edited chunk is remeshed together with only the neighbours across the
+// faces, edges or corners its box touches, within the border layers each
+// neighbour reads at its level of detail, and as long as that is a
+// handful of chunks they are meshed right away, bypassing the workers and
+// the budget, so the edit shows up the same frame.
+//
+// Chunks far from the viewer are meshed at a coarser level of detail,
+// picked by their distance from the viewer's chunk and re-picked whenever
+// the viewer enters another chunk. Coarse meshes carry their own skirts
+// (see LodChunkVoxels), so a chunk changing level never needs its
+// neighbours remeshed.
+//
+// Every mesh goes through a content-hash cache first, so chunks that come
+// back unchanged, or look like chunks meshed before, skip meshing.
+class WorldNode : public SceneNode {
+ public:
+  WorldNode(std::unique_ptr<World> world, const SceneNode& viewer);
+
+  void Update(double delta_time) override;
+
+  World& GetWorld() {
+    return *world_;
+  }
+  // Drops every chunk mesh of the current world and streams in the new one.
+  void SetWorld(std::unique_ptr<World> world);
+
+  // Switching modes remeshes every loaded chunk.
+  void SetMesherMode(MesherMode mode);
+  MesherMode GetMesherMode() const {
+    return mesher_mode_;
+  }
+
+  void SetUploadBudget(const ChunkUploadBudget& budget) {
+    upload_budget_ = budget;
+  }
+  const ChunkUploadBudget& GetUploadBudget() const {
+    return upload_budget_;
+  }
+  // Takes effect on the next update, which remeshes the chunks whose level
+  // changes.
+  void SetLodSettings(const ChunkLodSettings& settings) {
+    lod_settings_ = settings;
+    lods_valid_ = false;
+  }
+  const ChunkLodSettings& GetLodSettings() const {
+    return lod_settings_;
+  }
+
+  // Meshes by content, shared by the workers and immediate remeshes.
+  ChunkMeshCache& GetMeshCache() {
+    return mesh_cache_;
+  }
+
+  // Chunks waiting for a mesh or for their upload.
+  size_t GetPendingMeshCount() const {
+    return mesh_queue_.GetPendingCount();
+  }
+
+ private:
+  using ChunkSet = std::unordered_set<ChunkCoord, ChunkCoordHash>;
+
+  // Beyond this many chunks edited in one frame, the edits go through the
+  // workers like any other remesh.
+  static const size_t kMaxImmediateRemeshes = 8;
+
+  void QueueWithNeighbors(const ChunkCoord& coord, ChunkSet& queue) const;
+  void QueueEdit(const ChunkEdit& edit, ChunkSet& queue) const;
+  // Queues the chunks whose level of detail changed since their last mesh.
+  void UpdateLods(const glm::vec3& viewer_position, ChunkSet& queue);
+  int SelectLod(const ChunkCoord& coord) const;
+  void RemeshChunk(const ChunkCoord& coord, bool immediate = false);
+  void UploadMeshes();
+
+  std::unique_ptr<World> world_;
+  const SceneNode& viewer_;
+  ChunkRenderer renderer_;
+  MesherMode mesher_mode_;
+  ChunkUploadBudget upload_budget_;
+  ChunkLodSettings lod_settings_;
+  // Viewer chunk the levels were last picked from.
+  ChunkCoord lod_center_;
+  bool lods_valid_;
+  // Level of the latest mesh of every chunk that has one.
+  std::unordered_map<ChunkCoord, int, ChunkCoordHash> chunk_lods_;
+  ChunkMeshCache mesh_cache_;
+  // Declared after mesh_cache_ and world_, so the pool joins its threads
+  // before the cache and the generation pipeline the workers use are torn
+  // down, and before mesh_queue_, which keeps a reference to it. Generation
+  // tasks still queued then are dropped; they hold their own share of the
+  // pipeline.
+  ThreadPool worker_pool_;
+  ChunkMeshQueue mesh_queue_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,408 @@
+#include "ChunkGenerationPipeline.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace GLOO {
+namespace {
+// Indexed by GenerationStage. Trees reach less than a chunk into their
+// neighbours, so placing them needs the heightmaps of the adjacent chunks
+// only; every other stage reads nothing but its own chunk.
+const GenerationStageRequirement kStageRequirements[kGenerationStageCount] =
+    {
+        {0, GenerationStage::None},       // None
+        {0, GenerationStage::None},       // Heightmap
+        {0, GenerationStage::None},       // Terrain
+        {0, GenerationStage::None},       // Caves
+        {0, GenerationStage::None},       // Surface
+        {1, GenerationStage::Heightmap},  // Structures
+};
+
+// Largest horizontal_radius above.
+const int kMaxNeighborRadius = 1;
+
+const char* const kStageNames[kGenerationStageCount] = {
+    "none", "heightmap", "terrain", "caves", "surface", "structures",
+};
+
+GenerationStage NextStage(GenerationStage stage) {
+  return static_cast<GenerationStage>(static_cast<int>(stage) + 1);
+}
+
+ChunkCoord ColumnOf(const ChunkCoord& coord) {
+  return ChunkCoord(coord.x, 0, coord.z);
+}
+}  // namespace
+
+GenerationStageRequirement GetStageRequirement(GenerationStage stage) {
+  int index = static_cast<int>(stage);
+  if (index < 0 || index >= kGenerationStageCount)
+    throw std::runtime_error("Unknown generation stage!");
+  return kStageRequirements[index];
+}
+
+const char* GetGenerationStageName(GenerationStage stage) {
+  int index = static_cast<int>(stage);
+  if (index < 0 || index >= kGenerationStageCount)
+    return "unknown";
+  return kStageNames[index];
+}
+
+ChunkGenerationPipeline::ChunkGenerationPipeline(
+    ThreadPool& pool, std::shared_ptr<const TerrainGenerator> generator)
+    : pool_(pool), state_(std::make_shared<State>()) {
+  if (generator == nullptr)
+    throw std::runtime_error("Generation pipeline needs a generator!");
+  state_->generator = std::move(generator);
+}
+
+ChunkGenerationPipeline::~ChunkGenerationPipeline() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->stopping = true;
+  state_->entries.clear();
+  state_->ready.clear();
+  state_->heightmaps.clear();
+  state_->completed.clear();
+}
+
+void ChunkGenerationPipeline::Request(const ChunkCoord& coord) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  State& state = *state_;
+  std::shared_ptr<Entry>& slot = state.entries[coord];
+  if (slot == nullptr)
+    slot = std::make_shared<Entry>();
+  Entry& entry = *slot;
+  if (entry.requested)
+    return;
+  entry.requested = true;
+  state.requested_count++;
+  // A chunk handed out or cancelled after it finished keeps its heightmap
+  // but is generated again from there.
+  if (entry.stage == kFinalGenerationStage && !entry.running) {
+    entry.stage = GenerationStage::Heightmap;
+    auto& completed = state.completed;
+    completed.erase(std::remove_if(completed.begin(), completed.end(),
+                                   [&](const std::unique_ptr<Chunk>& chunk) {
+                                     return chunk->GetCoord() == coord;
+                                   }),
+                    completed.end());
+  }
+  EnsureNeighbors(state, coord);
+  UpdateReadiness(state, coord);
+  Schedule(state_, pool_);
+}
+
+void ChunkGenerationPipeline::Cancel(const ChunkCoord& coord) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  State& state = *state_;
+  auto itr = state.entries.find(coord);
+  if (itr == state.entries.end() || !itr->second->requested)
+    return;
+  itr->second->requested = false;
+  state.requested_count--;
+  UpdateReadiness(state, coord);
+  DropUnneeded(state, coord);
+}
+
+void ChunkGenerationPipeline::CancelUnless(
+    const std::function<bool(const ChunkCoord&)>& keep) {
+  std::vector<ChunkCoord> cancelled;
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    for (const auto& entry : state_->entries) {
+      if (entry.second->requested && !keep(entry.first))
+        cancelled.push_back(entry.first);
+    }
+  }
+  for (const ChunkCoord& coord : cancelled)
+    Cancel(coord);
+}
+
+void ChunkGenerationPipeline::CancelAll() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  // Stages still running find their entry gone and drop their result.
+  state_->entries.clear();
+  state_->ready.clear();
+  state_->heightmaps.clear();
+  state_->completed.clear();
+  state_->requested_count = 0;
+}
+
+void ChunkGenerationPipeline::SetFocus(const glm::vec3& position) {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  state_->focus = position;
+}
+
+std::vector<std::unique_ptr<Chunk>> ChunkGenerationPipeline::TakeCompleted() {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  State& state = *state_;
+  std::vector<std::unique_ptr<Chunk>> chunks;
+  std::vector<std::unique_ptr<Chunk>> completed;
+  completed.swap(state.completed);
+  for (std::unique_ptr<Chunk>& chunk : completed) {
+    ChunkCoord coord = chunk->GetCoord();
+    auto itr = state.entries.find(coord);
+    // Chunks cancelled since they finished are dropped.
+    if (itr == state.entries.end() || !itr->second->requested)
+      continue;
+    itr->second->requested = false;
+    state.requested_count--;
+    chunks.push_back(std::move(chunk));
+    DropUnneeded(state, coord);
+  }
+  return chunks;
+}
+
+bool ChunkGenerationPipeline::IsRequested(const ChunkCoord& coord) const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  auto itr = state_->entries.find(coord);
+  return itr != state_->entries.end() && itr->second->requested;
+}
+
+size_t ChunkGenerationPipeline::GetPendingCount() const {
+  std::lock_guard<std::mutex> lock(state_->mutex);
+  return state_->requested_count;
+}
+
+GenerationStage ChunkGenerationPipeline::GetTarget(const State& state,
+                                                   const ChunkCoord& coord,
+                                                   const Entry& entry) {
+  if (entry.requested)
+    return kFinalGenerationStage;
+  // Otherwise as far as the stages requested neighbours have left need.
+  GenerationStage target = GenerationStage::None;
+  for (int dz = -kMaxNeighborRadius; dz <= kMaxNeighborRadius; dz++) {
+    for (int dx = -kMaxNeighborRadius; dx <= kMaxNeighborRadius; dx++) {
+      if (dx == 0 && dz == 0)
+        continue;
+      auto itr = state.entries.find(coord + glm::ivec3(dx, 0, dz));
+      if (itr == state.entries.end() || !itr->second->requested)
+        continue;
+      for (int stage = static_cast<int>(itr->second->stage) + 1;
+           stage < kGenerationStageCount; stage++) {
+        GenerationStageRequirement requirement = kStageRequirements[stage];
+        if (std::abs(dx) <= requirement.horizontal_radius &&
+            std::abs(dz) <= requirement.horizontal_radius &&
+            requirement.neighbor_stage > target)
+          target = requirement.neighbor_stage;
+      }
+    }
+  }
+  return target;
+}
+
+bool ChunkGenerationPipeline::IsReady(const State& state,
+                                      const ChunkCoord& coord,
+                                      const Entry& entry) {
+  if (entry.running || entry.stage >= GetTarget(state, coord, entry))
+    return false;
+  GenerationStageRequirement requirement =
+      kStageRequirements[static_cast<int>(NextStage(entry.stage))];
+  int radius = requirement.horizontal_radius;
+  for (int dz = -radius; dz <= radius; dz++) {
+    for (int dx = -radius; dx <= radius; dx++) {
+      auto itr = state.entries.find(coord + glm::ivec3(dx, 0, dz));
+      if (itr == state.entries.end() ||
+          itr->second->stage < requirement.neighbor_stage)
+        return false;
+    }
+  }
+  return true;
+}
+
+void ChunkGenerationPipeline::UpdateReadiness(State& state,
+                                              const ChunkCoord& coord) {
+  for (int dz = -kMaxNeighborRadius; dz <= kMaxNeighborRadius; dz++) {
+    for (int dx = -kMaxNeighborRadius; dx <= kMaxNeighborRadius; dx++) {
+      ChunkCoord neighbor = coord + glm::ivec3(dx, 0, dz);
+      auto itr = state.entries.find(neighbor);
+      if (itr != state.entries.end() &&
+          IsReady(state, neighbor, *itr->second))
+        state.ready.insert(neighbor);
+      else
+        state.ready.erase(neighbor);
+    }
+  }
+}
+
+void ChunkGenerationPipeline::EnsureNeighbors(State& state,
+                                              const ChunkCoord& coord) {
+  for (int dz = -kMaxNeighborRadius; dz <= kMaxNeighborRadius; dz++) {
+    for (int dx = -kMaxNeighborRadius; dx <= kMaxNeighborRadius; dx++) {
+      ChunkCoord neighbor = coord + glm::ivec3(dx, 0, dz);
+      std::shared_ptr<Entry>& slot = state.entries[neighbor];
+      if (slot == nullptr) {
+        slot = std::make_shared<Entry>();
+        UpdateReadiness(state, neighbor);
+      }
+    }
+  }
+}
+
+void ChunkGenerationPipeline::DropUnneeded(State& state,
+                                           const ChunkCoord& coord) {
+  for (int dz = -kMaxNeighborRadius; dz <= kMaxNeighborRadius; dz++) {
+    for (int dx = -kMaxNeighborRadius; dx <= kMaxNeighborRadius; dx++) {
+      ChunkCoord neighbor = coord + glm::ivec3(dx, 0, dz);
+      auto itr = state.entries.find(neighbor);
+      if (itr == state.entries.end())
+        continue;
+      const Entry& entry = *itr->second;
+      // Running entries are looked at again once their stage finishes.
+      if (entry.running || entry.requested ||
+          GetTarget(state, neighbor, entry) != GenerationStage::None)
+        continue;
+      state.entries.erase(itr);
+      state.ready.erase(neighbor);
+      auto heightmap = state.heightmaps.find(ColumnOf(neighbor));
+      if (heightmap != state.heightmaps.end() && heightmap->second.expired())
+        state.heightmaps.erase(heightmap);
+    }
+  }
+}
+
+bool ChunkGenerationPipeline::PickJob(State& state, Job& job) {
+  while (!state.ready.empty()) {
+    // Nearest ready chunk to the focus. The ready set stays small, a few
+    // rings of chunks around the ones in flight, so a scan is cheap.
+    auto best = state.ready.end();
+    float best_distance = std::numeric_limits<float>::max();
+    for (auto itr = state.ready.begin(); itr != state.ready.end(); ++itr) {
+      glm::vec3 center =
+          glm::vec3(ChunkOrigin(*itr)) + glm::vec3(kChunkSize * 0.5f);
+      glm::vec3 offset = center - state.focus;
+      float distance = glm::dot(offset, offset);
+      if (distance < best_distance) {
+        best_distance = distance;
+        best = itr;
+      }
+    }
+    ChunkCoord coord = *best;
+    state.ready.erase(best);
+    auto itr = state.entries.find(coord);
+    if (itr == state.entries.end() || !IsReady(state, coord, *itr->second))
+      continue;
+    std::shared_ptr<Entry> entry = itr->second;
+    GenerationStage stage = NextStage(entry->stage);
+
+    // Chunks stacked in a column share the heightmap of whichever got to
+    // it first.
+    if (stage == GenerationStage::Heightmap) {
+      auto shared = state.heightmaps.find(ColumnOf(coord));
+      if (shared != state.heightmaps.end()) {
+        entry->heightmap = shared->second.lock();
+        if (entry->heightmap != nullptr) {
+          entry->stage = stage;
+          UpdateReadiness(state, coord);
+          continue;
+        }
+      }
+    }
+
+    entry->running = true;
+    job.coord = coord;
+    job.entry = entry;
+    job.stage = stage;
+    job.chunk = std::move(entry->chunk);
+    job.heightmap = entry->heightmap;
+    GenerationStageRequirement requirement =
+        kStageRequirements[static_cast<int>(stage)];
+    for (int dz = -1; dz <= 1; dz++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        std::shared_ptr<const ChunkHeightmap>& neighbor =
+            job.neighbors[(dx + 1) + 3 * (dz + 1)];
+        neighbor = nullptr;
+        if (std::abs(dx) > requirement.horizontal_radius ||
+            std::abs(dz) > requirement.horizontal_radius)
+          continue;
+        neighbor = state.entries.at(coord + glm::ivec3(dx, 0, dz))->heightmap;
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
+void ChunkGenerationPipeline::RunJob(const TerrainGenerator& generator,
+                                     Job& job) {
+  switch (job.stage) {
+    case GenerationStage::Heightmap: {
+      auto heightmap = std::make_shared<ChunkHeightmap>();
+      generator.ComputeHeightmap(job.coord, *heightmap);
+      job.heightmap = heightmap;
+      break;
+    }
+    case GenerationStage::Terrain:
+      job.chunk.reset(new Chunk(job.coord));
+      generator.FillTerrain(*job.chunk, *job.heightmap);
+      break;
+    case GenerationStage::Caves:
+      generator.CarveCaves(*job.chunk, *job.heightmap);
+      break;
+    case GenerationStage::Surface:
+      generator.CoverSurface(*job.chunk, *job.heightmap);
+      break;
+    case GenerationStage::Structures: {
+      const ChunkHeightmap* neighbors[9];
+      for (int i = 0; i < 9; i++)
+        neighbors[i] = job.neighbors[i].get();
+      generator.PlaceTrees(*job.chunk, neighbors);
+      // Solid stone or all-water chunks need no payload.
+      job.chunk->Compact();
+      break;
+    }
+    case GenerationStage::None:
+      break;
+  }
+}
+
+void ChunkGenerationPipeline::FinishJob(State& state, Job& job) {
+  job.entry->running = false;
+  auto itr = state.entries.find(job.coord);
+  // Cancelled (and possibly requested again) while it ran.
+  if (itr == state.entries.end() || itr->second != job.entry)
+    return;
+  Entry& entry = *job.entry;
+  entry.stage = job.stage;
+  entry.heightmap = job.heightmap;
+  if (job.stage == GenerationStage::Heightmap)
+    state.heightmaps[ColumnOf(job.coord)] = job.heightmap;
+  if (job.stage == kFinalGenerationStage) {
+    if (entry.requested)
+      state.completed.push_back(std::move(job.chunk));
+  } else {
+    entry.chunk = std::move(job.chunk);
+  }
+  UpdateReadiness(state, job.coord);
+  DropUnneeded(state, job.coord);
+}
+
+void ChunkGenerationPipeline::RunTask(const std::shared_ptr<State>& state,
+                                      ThreadPool& pool) {
+  Job job;
+  {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->queued_tasks--;
+    if (state->stopping || !PickJob(*state, job))
+      return;
+  }
+  RunJob(*state->generator, job);
+  std::lock_guard<std::mutex> lock(state->mutex);
+  FinishJob(*state, job);
+  if (!state->stopping)
+    Schedule(state, pool);
+}
+
+void ChunkGenerationPipeline::Schedule(const std::shared_ptr<State>& state,
+                                       ThreadPool& pool) {
+  // One stage per task, so generation shares the workers fairly with
+  // whatever else runs on the pool.
+  while (state->queued_tasks < pool.GetThreadCount() &&
+         state->queued_tasks < state->ready.size()) {
+    state->queued_tasks++;
+    pool.Submit([state, &pool]() { RunTask(state, pool); });
+  }
+}
+}  // namespace GLOO
@@ -0,0 +1,156 @@
+#ifndef CHUNK_GENERATION_PIPELINE_H_
+#define CHUNK_GENERATION_PIPELINE_H_
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+#include "TerrainGenerator.hpp"
+
+namespace GLOO {
+// Stages a chunk goes through, in order; each names the last one finished.
+enum class GenerationStage {
+  None,
+  Heightmap,
+  Terrain,
+  Caves,
+  Surface,
+  // Trees, including the parts of trees rooted in neighbouring chunks.
+  Structures,
+};
+
+const int kGenerationStageCount = 6;
+const GenerationStage kFinalGenerationStage = GenerationStage::Structures;
+
+// What a stage needs from the chunks around it before it can run, on top of
+// the chunk itself having finished the previous stage: every chunk within
+// horizontal_radius in x and z, at the same height, must have reached
+// neighbor_stage.
+struct GenerationStageRequirement {
+  int horizontal_radius;
+  GenerationStage neighbor_stage;
+};
+
+// Requirements of each stage, indexed by GenerationStage.
+GenerationStageRequirement GetStageRequirement(GenerationStage stage);
+const char* GetGenerationStageName(GenerationStage stage);
+
+// Generates chunks on a thread pool, one stage at a time. A chunk's next
+// stage runs as soon as the chunk and the neighbours that stage depends on
+// are far enough along, so independent chunks, and different stages of
+// neighbouring ones, proceed on all workers at once. Neighbours a requested
+// chunk depends on are brought up to the stage it needs, but no further.
+//
+// Stages only ever write the chunk they run on and read finished,
+// immutable products (heightmaps) of their neighbours, so there is no
+// locking around chunk data and no race at chunk borders: a chunk is
+// touched by one worker at a time and the result does not depend on the
+// order stages ran in.
+//
+// Among the stages ready to run, workers always pick the one whose chunk is
+// nearest to the focus (normally the player). The pool itself runs tasks
+// in FIFO order, so the pipeline keeps at most one task per worker queued
+// and each task picks its stage only when it starts.
+//
+// Requests, cancellation and TakeCompleted must come from one thread.
+class ChunkGenerationPipeline {
+ public:
+  // Stages still queued or running when the pipeline is destroyed finish
+  // or are skipped on the pool, and their chunks are dropped.
+  ChunkGenerationPipeline(ThreadPool& pool,
+                          std::shared_ptr<const TerrainGenerator> generator);
+  ~ChunkGenerationPipeline();
+
+  ChunkGenerationPipeline(const ChunkGenerationPipeline&) = delete;
+  void operator=(const ChunkGenerationPipeline&) = delete;
+
+  // Starts generating a chunk, unless it is already requested.
+  void Request(const ChunkCoord& coord);
+  void Cancel(const ChunkCoord& coord);
+  // Cancels every requested chunk for which keep returns false.
+  void CancelUnless(const std::function<bool(const ChunkCoord&)>& keep);
+  void CancelAll();
+
+  // Position, in world space, that stages are prioritized by.
+  void SetFocus(const glm::vec3& position);
+
+  // Hands out the chunks that finished every stage since the last call, in
+  // the order they finished.
+  std::vector<std::unique_ptr<Chunk>> TakeCompleted();
+
+  bool IsRequested(const ChunkCoord& coord) const;
+  // Requested chunks that TakeCompleted has not returned yet.
+  size_t GetPendingCount() const;
+
+ private:
+  struct Entry {
+    GenerationStage stage = GenerationStage::None;
+    // Requested chunks go all the way; others are only generated as far as
+    // a requested neighbour needs.
+    bool requested = false;
+    bool running = false;
+    std::unique_ptr<Chunk> chunk;
+    std::shared_ptr<const ChunkHeightmap> heightmap;
+  };
+  using EntryMap =
+      std::unordered_map<ChunkCoord, std::shared_ptr<Entry>, ChunkCoordHash>;
+  using CoordSet = std::unordered_set<ChunkCoord, ChunkCoordHash>;
+
+  // A stage picked to run, with everything it reads.
+  struct Job {
+    ChunkCoord coord;
+    std::shared_ptr<Entry> entry;
+    GenerationStage stage;
+    // The chunk's own data, moved out of the entry while the stage runs.
+    std::unique_ptr<Chunk> chunk;
+    std::shared_ptr<const ChunkHeightmap> heightmap;
+    // Heightmaps of the neighbours the stage reads, as for
+    // TerrainGenerator::PlaceTrees.
+    std::shared_ptr<const ChunkHeightmap> neighbors[9];
+  };
+
+  // Shared with the worker tasks, which may outlive the pipeline.
+  struct State {
+    std::mutex mutex;
+    std::shared_ptr<const TerrainGenerator> generator;
+    EntryMap entries;
+    // Entries whose next stage can run.
+    CoordSet ready;
+    // Heightmaps by column (y = 0), shared by the chunks stacked in it.
+    std::unordered_map<ChunkCoord, std::weak_ptr<const ChunkHeightmap>,
+                       ChunkCoordHash>
+        heightmaps;
+    std::vector<std::unique_ptr<Chunk>> completed;
+    glm::vec3 focus = glm::vec3(0.0f);
+    size_t requested_count = 0;
+    size_t queued_tasks = 0;
+    bool stopping = false;
+  };
+
+  static GenerationStage GetTarget(const State& state, const ChunkCoord& coord,
+                                   const Entry& entry);
+  static bool IsReady(const State& state, const ChunkCoord& coord,
+                      const Entry& entry);
+  // Re-checks readiness of an entry and the entries that may wait on it.
+  static void UpdateReadiness(State& state, const ChunkCoord& coord);
+  static void EnsureNeighbors(State& state, const ChunkCoord& coord);
+  // Drops the entries around coord that nothing needs anymore.
+  static void DropUnneeded(State& state, const ChunkCoord& coord);
+  static bool PickJob(State& state, Job& job);
+  static void RunJob(const TerrainGenerator& generator, Job& job);
+  static void FinishJob(State& state, Job& job);
+  static void RunTask(const std::shared_ptr<State>& state, ThreadPool& pool);
+  // Keeps one task per worker queued while there is work.
+  static void Schedule(const std::shared_ptr<State>& state, ThreadPool& pool);
+
+  ThreadPool& pool_;
+  std::shared_ptr<State> state_;
+};
+}  // namespace GLOO
+
+#endif
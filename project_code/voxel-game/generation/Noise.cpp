@@ -0,0 +1,373 @@
+#include "Noise.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "NoiseKernels.hpp"
+
+namespace GLOO {
+namespace {
+// The SIMD kernels in NoiseKernels.inl mirror every function in this
+// namespace operation for operation; keep them in step.
+
+inline float Fade(float t) {
+  return t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+inline float Lerp(float a, float b, float t) {
+  return a + t * (b - a);
+}
+
+inline float Negate(bool negate, float v) {
+  return negate ? -v : v;
+}
+
+// Gradients are picked arithmetically rather than from a table, so the
+// SIMD kernels can select them with masks. In 2D the low three hash bits
+// pick one of the four diagonals (1, 1) or one of the four axes.
+inline float Grad2(uint32_t hash, float x, float y) {
+  uint32_t h = hash & 7;
+  float u = (h & 6) == 6 ? y : x;
+  float v = (h & 4) == 0 ? y : 0.0f;
+  return Negate((h & 1) != 0, u) + Negate((h & 2) != 0, v);
+}
+
+// Ken Perlin's twelve cube-edge gradients, from the low four hash bits,
+// with four of them repeated.
+inline float Grad3(uint32_t hash, float x, float y, float z) {
+  uint32_t h = hash & 15;
+  float u = (h & 8) == 0 ? x : y;
+  float v = (h & 12) == 0 ? y : ((h & 13) == 12 ? x : z);
+  return Negate((h & 1) != 0, u) + Negate((h & 2) != 0, v);
+}
+
+inline float SimplexCorner2(uint32_t hash, float x, float y) {
+  float t = kSimplexRadius2D - x * x - y * y;
+  t = std::max(t, 0.0f);
+  t *= t;
+  return t * t * Grad2(hash, x, y);
+}
+
+inline float SimplexCorner3(uint32_t hash, float x, float y, float z) {
+  float t = kSimplexRadius3D - x * x - y * y - z * z;
+  t = std::max(t, 0.0f);
+  t *= t;
+  return t * t * Grad3(hash, x, y, z);
+}
+
+inline float Noise2D(NoiseBasis basis, float x, float y, uint32_t seed) {
+  return basis == NoiseBasis::Simplex ? SimplexNoise2D(x, y, seed)
+                                      : GradientNoise2D(x, y, seed);
+}
+
+inline float Noise3D(NoiseBasis basis, float x, float y, float z,
+                     uint32_t seed) {
+  return basis == NoiseBasis::Simplex ? SimplexNoise3D(x, y, z, seed)
+                                      : GradientNoise3D(x, y, z, seed);
+}
+
+NoiseIsa DetectNoiseIsa() {
+#if !defined(VOXEL_NOISE_X86)
+  return NoiseIsa::Scalar;
+#elif defined(_MSC_VER)
+  // AVX2 needs both the CPU flag and the OS saving the YMM registers.
+  int regs[4];
+  __cpuid(regs, 0);
+  if (regs[0] < 7)
+    return NoiseIsa::Sse2;
+  __cpuid(regs, 1);
+  bool os_saves_ymm = (regs[2] & (1 << 27)) != 0 &&
+                      (regs[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+  __cpuidex(regs, 7, 0);
+  return os_saves_ymm && (regs[1] & (1 << 5)) != 0 ? NoiseIsa::Avx2
+                                                   : NoiseIsa::Sse2;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") ? NoiseIsa::Avx2 : NoiseIsa::Sse2;
+#endif
+}
+
+// -1 until the first GetNoiseIsa() or SetNoiseIsa().
+std::atomic<int> active_noise_isa(-1);
+
+// Fills octave_seeds and returns true if the kernels can take the batch.
+bool GetOctaveSeeds(uint32_t seed, const FractalSettings& settings,
+                    uint32_t* octave_seeds) {
+  if (settings.octaves > kMaxBatchOctaves)
+    return false;
+  for (int octave = 0; octave < settings.octaves; octave++)
+    octave_seeds[octave] = DeriveSeed(seed, static_cast<uint32_t>(octave));
+  return true;
+}
+
+// Runs the kernels of the current instruction set; returns how many of the
+// points they evaluated.
+size_t RunKernel2D(const float* x, const float* y, size_t count,
+                   const uint32_t* octave_seeds,
+                   const FractalSettings& settings, float* out) {
+  switch (GetNoiseIsa()) {
+#ifdef VOXEL_NOISE_X86
+    case NoiseIsa::Avx2:
+      return noise_avx2::Fractal2D(x, y, count, octave_seeds, settings, out);
+    case NoiseIsa::Sse2:
+      return noise_sse2::Fractal2D(x, y, count, octave_seeds, settings, out);
+#endif
+    default:
+      return 0;
+  }
+}
+
+size_t RunKernel3D(const float* x, const float* y, const float* z,
+                   size_t count, const uint32_t* octave_seeds,
+                   const FractalSettings& settings, float* out) {
+  switch (GetNoiseIsa()) {
+#ifdef VOXEL_NOISE_X86
+    case NoiseIsa::Avx2:
+      return noise_avx2::Fractal3D(x, y, z, count, octave_seeds, settings,
+                                   out);
+    case NoiseIsa::Sse2:
+      return noise_sse2::Fractal3D(x, y, z, count, octave_seeds, settings,
+                                   out);
+#endif
+    default:
+      return 0;
+  }
+}
+}  // namespace
+
+float GradientNoise2D(float x, float y, uint32_t seed) {
+  float fx = std::floor(x);
+  float fy = std::floor(y);
+  int32_t ix = static_cast<int32_t>(fx);
+  int32_t iy = static_cast<int32_t>(fy);
+  float tx = x - fx;
+  float ty = y - fy;
+
+  float n00 = Grad2(HashLattice(ix, iy, 0, seed), tx, ty);
+  float n10 = Grad2(HashLattice(ix + 1, iy, 0, seed), tx - 1.0f, ty);
+  float n01 = Grad2(HashLattice(ix, iy + 1, 0, seed), tx, ty - 1.0f);
+  float n11 =
+      Grad2(HashLattice(ix + 1, iy + 1, 0, seed), tx - 1.0f, ty - 1.0f);
+
+  float u = Fade(tx);
+  float v = Fade(ty);
+  return Lerp(Lerp(n00, n10, u), Lerp(n01, n11, u), v);
+}
+
+float GradientNoise3D(float x, float y, float z, uint32_t seed) {
+  float fx = std::floor(x);
+  float fy = std::floor(y);
+  float fz = std::floor(z);
+  int32_t ix = static_cast<int32_t>(fx);
+  int32_t iy = static_cast<int32_t>(fy);
+  int32_t iz = static_cast<int32_t>(fz);
+  float tx = x - fx;
+  float ty = y - fy;
+  float tz = z - fz;
+
+  float n000 = Grad3(HashLattice(ix, iy, iz, seed), tx, ty, tz);
+  float n100 = Grad3(HashLattice(ix + 1, iy, iz, seed), tx - 1.0f, ty, tz);
+  float n010 = Grad3(HashLattice(ix, iy + 1, iz, seed), tx, ty - 1.0f, tz);
+  float n110 = Grad3(HashLattice(ix + 1, iy + 1, iz, seed), tx - 1.0f,
+                     ty - 1.0f, tz);
+  float n001 = Grad3(HashLattice(ix, iy, iz + 1, seed), tx, ty, tz - 1.0f);
+  float n101 = Grad3(HashLattice(ix + 1, iy, iz + 1, seed), tx - 1.0f, ty,
+                     tz - 1.0f);
+  float n011 = Grad3(HashLattice(ix, iy + 1, iz + 1, seed), tx, ty - 1.0f,
+                     tz - 1.0f);
+  float n111 = Grad3(HashLattice(ix + 1, iy + 1, iz + 1, seed), tx - 1.0f,
+                     ty - 1.0f, tz - 1.0f);
+
+  float u = Fade(tx);
+  float v = Fade(ty);
+  float w = Fade(tz);
+  return Lerp(Lerp(Lerp(n000, n100, u), Lerp(n010, n110, u), v),
+              Lerp(Lerp(n001, n101, u), Lerp(n011, n111, u), v), w);
+}
+
+float SimplexNoise2D(float x, float y, uint32_t seed) {
+  // Skew into the lattice of squares that split into two triangles each.
+  float s = (x + y) * kSimplexSkew2D;
+  float fi = std::floor(x + s);
+  float fj = std::floor(y + s);
+  float t = (fi + fj) * kSimplexUnskew2D;
+  float x0 = x - (fi - t);
+  float y0 = y - (fj - t);
+
+  // The middle corner steps along x in the lower triangle, y in the upper.
+  float i1 = x0 > y0 ? 1.0f : 0.0f;
+  float j1 = 1.0f - i1;
+  float x1 = x0 - i1 + kSimplexUnskew2D;
+  float y1 = y0 - j1 + kSimplexUnskew2D;
+  float x2 = x0 - 1.0f + 2.0f * kSimplexUnskew2D;
+  float y2 = y0 - 1.0f + 2.0f * kSimplexUnskew2D;
+
+  int32_t i = static_cast<int32_t>(fi);
+  int32_t j = static_cast<int32_t>(fj);
+  float n = SimplexCorner2(HashLattice(i, j, 0, seed), x0, y0) +
+            SimplexCorner2(HashLattice(i + static_cast<int32_t>(i1),
+                                       j + static_cast<int32_t>(j1), 0,
+                                       seed),
+                           x1, y1) +
+            SimplexCorner2(HashLattice(i + 1, j + 1, 0, seed), x2, y2);
+  return kSimplexScale2D * n;
+}
+
+float SimplexNoise3D(float x, float y, float z, uint32_t seed) {
+  float s = (x + y + z) * kSimplexSkew3D;
+  float fi = std::floor(x + s);
+  float fj = std::floor(y + s);
+  float fk = std::floor(z + s);
+  float t = (fi + fj + fk) * kSimplexUnskew3D;
+  float x0 = x - (fi - t);
+  float y0 = y - (fj - t);
+  float z0 = z - (fk - t);
+
+  // The skewed cube splits into six tetrahedra; the order of x0, y0 and z0
+  // picks the one holding the point and so the second and third corners.
+  bool xy = x0 >= y0;
+  bool yz = y0 >= z0;
+  bool xz = x0 >= z0;
+  float i1 = xy && xz ? 1.0f : 0.0f;
+  float j1 = !xy && yz ? 1.0f : 0.0f;
+  float k1 = !xz && !yz ? 1.0f : 0.0f;
+  float i2 = xy || xz ? 1.0f : 0.0f;
+  float j2 = !xy || yz ? 1.0f : 0.0f;
+  float k2 = !(xz && yz) ? 1.0f : 0.0f;
+
+  float x1 = x0 - i1 + kSimplexUnskew3D;
+  float y1 = y0 - j1 + kSimplexUnskew3D;
+  float z1 = z0 - k1 + kSimplexUnskew3D;
+  float x2 = x0 - i2 + 2.0f * kSimplexUnskew3D;
+  float y2 = y0 - j2 + 2.0f * kSimplexUnskew3D;
+  float z2 = z0 - k2 + 2.0f * kSimplexUnskew3D;
+  float x3 = x0 - 1.0f + 3.0f * kSimplexUnskew3D;
+  float y3 = y0 - 1.0f + 3.0f * kSimplexUnskew3D;
+  float z3 = z0 - 1.0f + 3.0f * kSimplexUnskew3D;
+
+  int32_t i = static_cast<int32_t>(fi);
+  int32_t j = static_cast<int32_t>(fj);
+  int32_t k = static_cast<int32_t>(fk);
+  uint32_t h0 = HashLattice(i, j, k, seed);
+  uint32_t h1 = HashLattice(i + static_cast<int32_t>(i1),
+                            j + static_cast<int32_t>(j1),
+                            k + static_cast<int32_t>(k1), seed);
+  uint32_t h2 = HashLattice(i + static_cast<int32_t>(i2),
+                            j + static_cast<int32_t>(j2),
+                            k + static_cast<int32_t>(k2), seed);
+  uint32_t h3 = HashLattice(i + 1, j + 1, k + 1, seed);
+  float n = SimplexCorner3(h0, x0, y0, z0) + SimplexCorner3(h1, x1, y1, z1) +
+            SimplexCorner3(h2, x2, y2, z2) + SimplexCorner3(h3, x3, y3, z3);
+  return kSimplexScale3D * n;
+}
+
+float FractalNoise2D(float x, float y, uint32_t seed,
+                     const FractalSettings& settings) {
+  float sum = 0.0f;
+  float amplitude = 1.0f;
+  float total_amplitude = 0.0f;
+  for (int octave = 0; octave < settings.octaves; octave++) {
+    uint32_t octave_seed = DeriveSeed(seed, static_cast<uint32_t>(octave));
+    sum += amplitude * Noise2D(settings.basis, x, y, octave_seed);
+    total_amplitude += amplitude;
+    x *= settings.lacunarity;
+    y *= settings.lacunarity;
+    amplitude *= settings.gain;
+  }
+  return total_amplitude > 0.0f ? sum / total_amplitude : 0.0f;
+}
+
+float FractalNoise3D(float x, float y, float z, uint32_t seed,
+                     const FractalSettings& settings) {
+  float sum = 0.0f;
+  float amplitude = 1.0f;
+  float total_amplitude = 0.0f;
+  for (int octave = 0; octave < settings.octaves; octave++) {
+    uint32_t octave_seed = DeriveSeed(seed, static_cast<uint32_t>(octave));
+    sum += amplitude * Noise3D(settings.basis, x, y, z, octave_seed);
+    total_amplitude += amplitude;
+    x *= settings.lacunarity;
+    y *= settings.lacunarity;
+    z *= settings.lacunarity;
+    amplitude *= settings.gain;
+  }
+  return total_amplitude > 0.0f ? sum / total_amplitude : 0.0f;
+}
+
+NoiseIsa GetSupportedNoiseIsa() {
+  static const NoiseIsa supported = DetectNoiseIsa();
+  return supported;
+}
+
+NoiseIsa GetNoiseIsa() {
+  int isa = active_noise_isa.load(std::memory_order_relaxed);
+  if (isa < 0) {
+    isa = static_cast<int>(GetSupportedNoiseIsa());
+    active_noise_isa.store(isa, std::memory_order_relaxed);
+  }
+  return static_cast<NoiseIsa>(isa);
+}
+
+void SetNoiseIsa(NoiseIsa isa) {
+  int supported = static_cast<int>(GetSupportedNoiseIsa());
+  active_noise_isa.store(std::min(static_cast<int>(isa), supported),
+                         std::memory_order_relaxed);
+}
+
+const char* GetNoiseIsaName(NoiseIsa isa) {
+  switch (isa) {
+    case NoiseIsa::Scalar:
+      return "scalar";
+    case NoiseIsa::Sse2:
+      return "sse2";
+    case NoiseIsa::Avx2:
+      return "avx2";
+  }
+  return "unknown";
+}
+
+void EvaluateNoise2D(NoiseBasis basis, const float* x, const float* y,
+                     size_t count, uint32_t seed, float* out) {
+  // A single octave of weight one with the seed itself, which the kernels
+  // reduce to the plain noise exactly.
+  FractalSettings settings(1, 1.0f, 1.0f, basis);
+  size_t done = RunKernel2D(x, y, count, &seed, settings, out);
+  for (size_t i = done; i < count; i++)
+    out[i] = Noise2D(basis, x[i], y[i], seed);
+}
+
+void EvaluateNoise3D(NoiseBasis basis, const float* x, const float* y,
+                     const float* z, size_t count, uint32_t seed, float* out) {
+  FractalSettings settings(1, 1.0f, 1.0f, basis);
+  size_t done = RunKernel3D(x, y, z, count, &seed, settings, out);
+  for (size_t i = done; i < count; i++)
+    out[i] = Noise3D(basis, x[i], y[i], z[i], seed);
+}
+
+void EvaluateFractalNoise2D(const float* x, const float* y, size_t count,
+                            uint32_t seed, const FractalSettings& settings,
+                            float* out) {
+  uint32_t octave_seeds[kMaxBatchOctaves];
+  size_t done = 0;
+  if (GetOctaveSeeds(seed, settings, octave_seeds))
+    done = RunKernel2D(x, y, count, octave_seeds, settings, out);
+  for (size_t i = done; i < count; i++)
+    out[i] = FractalNoise2D(x[i], y[i], seed, settings);
+}
+
+void EvaluateFractalNoise3D(const float* x, const float* y, const float* z,
+                            size_t count, uint32_t seed,
+                            const FractalSettings& settings, float* out) {
+  uint32_t octave_seeds[kMaxBatchOctaves];
+  size_t done = 0;
+  if (GetOctaveSeeds(seed, settings, octave_seeds))
+    done = RunKernel3D(x, y, z, count, octave_seeds, settings, out);
+  for (size_t i = done; i < count; i++)
+    out[i] = FractalNoise3D(x[i], y[i], z[i], seed, settings);
+}
+}  // namespace GLOO
@@ -0,0 +1,103 @@
+#ifndef NOISE_H_
+#define NOISE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace GLOO {
+// Stateless hashing and gradient noise for world generation. Every value is
+// a pure function of its inputs and the seed, with no tables or global
+// state, so chunks can be generated on any thread and in any order and
+// still come out bit-identical for a given build.
+
+// Multipliers of HashLattice, shared with the SIMD kernels.
+const uint32_t kLatticeHashX = 0x8da6b343u;
+const uint32_t kLatticeHashY = 0xd8163841u;
+const uint32_t kLatticeHashZ = 0xcb1ab31fu;
+const uint32_t kLatticeMix1 = 0x7feb352du;
+const uint32_t kLatticeMix2 = 0x846ca68bu;
+
+// Well-mixed 32-bit hash of a lattice point.
+inline uint32_t HashLattice(int32_t x, int32_t y, int32_t z, uint32_t seed) {
+  uint32_t h = seed;
+  h ^= static_cast<uint32_t>(x) * kLatticeHashX;
+  h ^= static_cast<uint32_t>(y) * kLatticeHashY;
+  h ^= static_cast<uint32_t>(z) * kLatticeHashZ;
+  h = (h ^ (h >> 16)) * kLatticeMix1;
+  h = (h ^ (h >> 15)) * kLatticeMix2;
+  return h ^ (h >> 16);
+}
+
+// Derives an independent seed, e.g. one per noise field or octave.
+inline uint32_t DeriveSeed(uint32_t seed, uint32_t stream) {
+  return HashLattice(static_cast<int32_t>(stream), 0x5eed, 0, seed);
+}
+
+// Perlin-style gradient noise: zero at lattice points, smooth (quintic
+// fade) in between. Simplex noise sums radial kernels over the corners of
+// the simplex around the point instead, which costs fewer corners in 3D
+// and shows fewer axis-aligned artifacts. Both lie roughly within [-1, 1].
+float GradientNoise2D(float x, float y, uint32_t seed);
+float GradientNoise3D(float x, float y, float z, uint32_t seed);
+float SimplexNoise2D(float x, float y, uint32_t seed);
+float SimplexNoise3D(float x, float y, float z, uint32_t seed);
+
+enum class NoiseBasis {
+  Gradient,
+  Simplex,
+};
+
+// Fractal sums of noise: each octave doubles the frequency (lacunarity)
+// and halves the amplitude (gain) of the previous one, with its own seed.
+// The sum is normalized back to roughly [-1, 1].
+struct FractalSettings {
+  FractalSettings(int octaves = 4, float lacunarity = 2.0f, float gain = 0.5f,
+                  NoiseBasis basis = NoiseBasis::Gradient)
+      : octaves(octaves), lacunarity(lacunarity), gain(gain), basis(basis) {
+  }
+
+  int octaves;
+  float lacunarity;
+  float gain;
+  NoiseBasis basis;
+};
+
+float FractalNoise2D(float x, float y, uint32_t seed,
+                     const FractalSettings& settings);
+float FractalNoise3D(float x, float y, float z, uint32_t seed,
+                     const FractalSettings& settings);
+
+// Instruction sets the batch functions below can run on, narrowest first.
+enum class NoiseIsa {
+  Scalar,
+  Sse2,  // 4 points at once.
+  Avx2,  // 8 points at once.
+};
+
+// The widest instruction set this CPU supports, detected once.
+NoiseIsa GetSupportedNoiseIsa();
+// The instruction set batch evaluation uses; the widest supported one
+// unless overridden. Requests beyond what the CPU supports fall back to
+// the widest it does. Meant for benchmarks and tests.
+NoiseIsa GetNoiseIsa();
+void SetNoiseIsa(NoiseIsa isa);
+const char* GetNoiseIsaName(NoiseIsa isa);
+
+// Batch evaluation over count points given as separate coordinate arrays,
+// vectorized with the current NoiseIsa. The SIMD kernels repeat the scalar
+// functions' arithmetic operation for operation, so results equal theirs
+// on every instruction set (up to the sign of an exact zero) and terrain
+// does not depend on the CPU it was generated on.
+void EvaluateNoise2D(NoiseBasis basis, const float* x, const float* y,
+                     size_t count, uint32_t seed, float* out);
+void EvaluateNoise3D(NoiseBasis basis, const float* x, const float* y,
+                     const float* z, size_t count, uint32_t seed, float* out);
+void EvaluateFractalNoise2D(const float* x, const float* y, size_t count,
+                            uint32_t seed, const FractalSettings& settings,
+                            float* out);
+void EvaluateFractalNoise3D(const float* x, const float* y, const float* z,
+                            size_t count, uint32_t seed,
+                            const FractalSettings& settings, float* out);
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef NOISE_KERNELS_H_
+#define NOISE_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Noise.hpp"
+
+// Internal to the noise implementation: constants the scalar functions and
+// the SIMD kernels must agree on, and the kernels' entry points.
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VOXEL_NOISE_X86 1
+#endif
+
+namespace GLOO {
+// Simplex (de)skewing factors: (sqrt(3) - 1) / 2 and (3 - sqrt(3)) / 6 in
+// 2D, 1/3 and 1/6 in 3D.
+const float kSimplexSkew2D = 0.36602540378f;
+const float kSimplexUnskew2D = 0.21132486540f;
+const float kSimplexSkew3D = 1.0f / 3.0f;
+const float kSimplexUnskew3D = 1.0f / 6.0f;
+// Squared radius of each corner's kernel, and the factor that brings the
+// sum to roughly [-1, 1].
+const float kSimplexRadius2D = 0.5f;
+const float kSimplexScale2D = 70.0f;
+const float kSimplexRadius3D = 0.6f;
+const float kSimplexScale3D = 32.0f;
+
+// Batches with more octaves than this fall back to the scalar functions.
+const int kMaxBatchOctaves = 16;
+
+#ifdef VOXEL_NOISE_X86
+// Each kernel evaluates fractal noise for the largest multiple of its width
+// of points, with one seed per octave, and returns how many points it did;
+// the caller finishes the rest with the scalar functions.
+namespace noise_sse2 {
+size_t Fractal2D(const float* x, const float* y, size_t count,
+                 const uint32_t* octave_seeds,
+                 const FractalSettings& settings, float* out);
+size_t Fractal3D(const float* x, const float* y, const float* z,
+                 size_t count, const uint32_t* octave_seeds,
+                 const FractalSettings& settings, float* out);
+}  // namespace noise_sse2
+
+namespace noise_avx2 {
+size_t Fractal2D(const float* x, const float* y, size_t count,
+                 const uint32_t* octave_seeds,
+                 const FractalSettings& settings, float* out);
+size_t Fractal3D(const float* x, const float* y, const float* z,
+                 size_t count, const uint32_t* octave_seeds,
+                 const FractalSettings& settings, float* out);
+}  // namespace noise_avx2
+#endif
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,277 @@
+// SIMD noise kernels, written once against a small set of vector
+// operations. NoiseSimd.cpp includes this file once per instruction set,
+// inside a namespace that defines the float and int vectors F and I, their
+// width kWidth, the operations used below, and NOISE_TARGET, the attribute
+// that enables the instruction set for a function.
+//
+// Every function mirrors its scalar counterpart in Noise.cpp operation for
+// operation, in the same order and without fused multiply-adds, so the
+// results match it exactly.
+
+NOISE_TARGET inline F Fade(F t) {
+  return Mul(Mul(Mul(t, t), t),
+             Add(Mul(t, Sub(Mul(t, Set(6.0f)), Set(15.0f))), Set(10.0f)));
+}
+
+NOISE_TARGET inline F Lerp(F a, F b, F t) {
+  return Add(a, Mul(t, Sub(b, a)));
+}
+
+// Moves bit `bit` of h into the sign bit, to negate by XOR.
+template <int bit>
+NOISE_TARGET inline F SignFromBit(I h) {
+  return AsFloat(ShiftLeftI<31 - bit>(AndI(h, SetI(1u << bit))));
+}
+
+// Mask of lanes where (h & mask) == value.
+NOISE_TARGET inline F MaskedEqual(I h, uint32_t mask, uint32_t value) {
+  return EqualI(AndI(h, SetI(mask)), SetI(value));
+}
+
+// HashLattice of lattice coordinates already multiplied by their
+// kLatticeHash constants.
+NOISE_TARGET inline I Hash(I seed, I hx, I hy) {
+  I h = XorI(XorI(seed, hx), hy);
+  h = MulLoI(XorI(h, ShiftRightI<16>(h)), SetI(kLatticeMix1));
+  h = MulLoI(XorI(h, ShiftRightI<15>(h)), SetI(kLatticeMix2));
+  return XorI(h, ShiftRightI<16>(h));
+}
+
+NOISE_TARGET inline I Hash(I seed, I hx, I hy, I hz) {
+  return Hash(XorI(seed, hz), hx, hy);
+}
+
+NOISE_TARGET inline F Grad2(I hash, F x, F y) {
+  I h = AndI(hash, SetI(7));
+  F u = Select(MaskedEqual(h, 6, 6), y, x);
+  F v = And(MaskedEqual(h, 4, 0), y);
+  return Add(Xor(u, SignFromBit<0>(h)), Xor(v, SignFromBit<1>(h)));
+}
+
+NOISE_TARGET inline F Grad3(I hash, F x, F y, F z) {
+  I h = AndI(hash, SetI(15));
+  F u = Select(MaskedEqual(h, 8, 0), x, y);
+  F v = Select(MaskedEqual(h, 12, 0), y,
+               Select(MaskedEqual(h, 13, 12), x, z));
+  return Add(Xor(u, SignFromBit<0>(h)), Xor(v, SignFromBit<1>(h)));
+}
+
+NOISE_TARGET inline F Gradient2D(F x, F y, I seed) {
+  F fx = Floor(x);
+  F fy = Floor(y);
+  I ix = ToInt(fx);
+  I iy = ToInt(fy);
+  F tx = Sub(x, fx);
+  F ty = Sub(y, fy);
+  F tx1 = Sub(tx, Set(1.0f));
+  F ty1 = Sub(ty, Set(1.0f));
+
+  I hx0 = MulLoI(ix, SetI(kLatticeHashX));
+  I hx1 = MulLoI(AddI(ix, SetI(1)), SetI(kLatticeHashX));
+  I hy0 = MulLoI(iy, SetI(kLatticeHashY));
+  I hy1 = MulLoI(AddI(iy, SetI(1)), SetI(kLatticeHashY));
+
+  F n00 = Grad2(Hash(seed, hx0, hy0), tx, ty);
+  F n10 = Grad2(Hash(seed, hx1, hy0), tx1, ty);
+  F n01 = Grad2(Hash(seed, hx0, hy1), tx, ty1);
+  F n11 = Grad2(Hash(seed, hx1, hy1), tx1, ty1);
+
+  F u = Fade(tx);
+  F v = Fade(ty);
+  return Lerp(Lerp(n00, n10, u), Lerp(n01, n11, u), v);
+}
+
+NOISE_TARGET inline F Gradient3D(F x, F y, F z, I seed) {
+  F fx = Floor(x);
+  F fy = Floor(y);
+  F fz = Floor(z);
+  I ix = ToInt(fx);
+  I iy = ToInt(fy);
+  I iz = ToInt(fz);
+  F tx = Sub(x, fx);
+  F ty = Sub(y, fy);
+  F tz = Sub(z, fz);
+  F tx1 = Sub(tx, Set(1.0f));
+  F ty1 = Sub(ty, Set(1.0f));
+  F tz1 = Sub(tz, Set(1.0f));
+
+  I hx0 = MulLoI(ix, SetI(kLatticeHashX));
+  I hx1 = MulLoI(AddI(ix, SetI(1)), SetI(kLatticeHashX));
+  I hy0 = MulLoI(iy, SetI(kLatticeHashY));
+  I hy1 = MulLoI(AddI(iy, SetI(1)), SetI(kLatticeHashY));
+  I hz0 = MulLoI(iz, SetI(kLatticeHashZ));
+  I hz1 = MulLoI(AddI(iz, SetI(1)), SetI(kLatticeHashZ));
+
+  F n000 = Grad3(Hash(seed, hx0, hy0, hz0), tx, ty, tz);
+  F n100 = Grad3(Hash(seed, hx1, hy0, hz0), tx1, ty, tz);
+  F n010 = Grad3(Hash(seed, hx0, hy1, hz0), tx, ty1, tz);
+  F n110 = Grad3(Hash(seed, hx1, hy1, hz0), tx1, ty1, tz);
+  F n001 = Grad3(Hash(seed, hx0, hy0, hz1), tx, ty, tz1);
+  F n101 = Grad3(Hash(seed, hx1, hy0, hz1), tx1, ty, tz1);
+  F n011 = Grad3(Hash(seed, hx0, hy1, hz1), tx, ty1, tz1);
+  F n111 = Grad3(Hash(seed, hx1, hy1, hz1), tx1, ty1, tz1);
+
+  F u = Fade(tx);
+  F v = Fade(ty);
+  F w = Fade(tz);
+  return Lerp(Lerp(Lerp(n000, n100, u), Lerp(n010, n110, u), v),
+              Lerp(Lerp(n001, n101, u), Lerp(n011, n111, u), v), w);
+}
+
+NOISE_TARGET inline F SimplexCorner2(I hash, F x, F y) {
+  F t = Sub(Sub(Set(kSimplexRadius2D), Mul(x, x)), Mul(y, y));
+  t = Max(t, Set(0.0f));
+  t = Mul(t, t);
+  return Mul(Mul(t, t), Grad2(hash, x, y));
+}
+
+NOISE_TARGET inline F SimplexCorner3(I hash, F x, F y, F z) {
+  F t = Sub(Sub(Sub(Set(kSimplexRadius3D), Mul(x, x)), Mul(y, y)),
+            Mul(z, z));
+  t = Max(t, Set(0.0f));
+  t = Mul(t, t);
+  return Mul(Mul(t, t), Grad3(hash, x, y, z));
+}
+
+NOISE_TARGET inline F Simplex2D(F x, F y, I seed) {
+  F one = Set(1.0f);
+  F s = Mul(Add(x, y), Set(kSimplexSkew2D));
+  F fi = Floor(Add(x, s));
+  F fj = Floor(Add(y, s));
+  F t = Mul(Add(fi, fj), Set(kSimplexUnskew2D));
+  F x0 = Sub(x, Sub(fi, t));
+  F y0 = Sub(y, Sub(fj, t));
+
+  F i1 = And(Greater(x0, y0), one);
+  F j1 = Sub(one, i1);
+  F x1 = Add(Sub(x0, i1), Set(kSimplexUnskew2D));
+  F y1 = Add(Sub(y0, j1), Set(kSimplexUnskew2D));
+  F x2 = Add(Sub(x0, one), Set(2.0f * kSimplexUnskew2D));
+  F y2 = Add(Sub(y0, one), Set(2.0f * kSimplexUnskew2D));
+
+  I i = ToInt(fi);
+  I j = ToInt(fj);
+  I hx0 = MulLoI(i, SetI(kLatticeHashX));
+  I hy0 = MulLoI(j, SetI(kLatticeHashY));
+  I hx1 = MulLoI(AddI(i, ToInt(i1)), SetI(kLatticeHashX));
+  I hy1 = MulLoI(AddI(j, ToInt(j1)), SetI(kLatticeHashY));
+  I hx2 = MulLoI(AddI(i, SetI(1)), SetI(kLatticeHashX));
+  I hy2 = MulLoI(AddI(j, SetI(1)), SetI(kLatticeHashY));
+
+  F n = Add(Add(SimplexCorner2(Hash(seed, hx0, hy0), x0, y0),
+                SimplexCorner2(Hash(seed, hx1, hy1), x1, y1)),
+            SimplexCorner2(Hash(seed, hx2, hy2), x2, y2));
+  return Mul(Set(kSimplexScale2D), n);
+}
+
+NOISE_TARGET inline F Simplex3D(F x, F y, F z, I seed) {
+  F one = Set(1.0f);
+  F s = Mul(Add(Add(x, y), z), Set(kSimplexSkew3D));
+  F fi = Floor(Add(x, s));
+  F fj = Floor(Add(y, s));
+  F fk = Floor(Add(z, s));
+  F t = Mul(Add(Add(fi, fj), fk), Set(kSimplexUnskew3D));
+  F x0 = Sub(x, Sub(fi, t));
+  F y0 = Sub(y, Sub(fj, t));
+  F z0 = Sub(z, Sub(fk, t));
+
+  // AndNot(a, b) is ~a & b, so AndNot(mask, one) is 1 where mask is clear.
+  F xy = GreaterEqual(x0, y0);
+  F yz = GreaterEqual(y0, z0);
+  F xz = GreaterEqual(x0, z0);
+  F i1 = And(And(xy, xz), one);
+  F j1 = And(AndNot(xy, yz), one);
+  F k1 = AndNot(Or(xz, yz), one);
+  F i2 = And(Or(xy, xz), one);
+  F j2 = AndNot(AndNot(yz, xy), one);
+  F k2 = AndNot(And(xz, yz), one);
+
+  F g1 = Set(kSimplexUnskew3D);
+  F g2 = Set(2.0f * kSimplexUnskew3D);
+  F g3 = Set(3.0f * kSimplexUnskew3D);
+  F x1 = Add(Sub(x0, i1), g1);
+  F y1 = Add(Sub(y0, j1), g1);
+  F z1 = Add(Sub(z0, k1), g1);
+  F x2 = Add(Sub(x0, i2), g2);
+  F y2 = Add(Sub(y0, j2), g2);
+  F z2 = Add(Sub(z0, k2), g2);
+  F x3 = Add(Sub(x0, one), g3);
+  F y3 = Add(Sub(y0, one), g3);
+  F z3 = Add(Sub(z0, one), g3);
+
+  I i = ToInt(fi);
+  I j = ToInt(fj);
+  I k = ToInt(fk);
+  I h0 = Hash(seed, MulLoI(i, SetI(kLatticeHashX)),
+              MulLoI(j, SetI(kLatticeHashY)), MulLoI(k, SetI(kLatticeHashZ)));
+  I h1 = Hash(seed, MulLoI(AddI(i, ToInt(i1)), SetI(kLatticeHashX)),
+              MulLoI(AddI(j, ToInt(j1)), SetI(kLatticeHashY)),
+              MulLoI(AddI(k, ToInt(k1)), SetI(kLatticeHashZ)));
+  I h2 = Hash(seed, MulLoI(AddI(i, ToInt(i2)), SetI(kLatticeHashX)),
+              MulLoI(AddI(j, ToInt(j2)), SetI(kLatticeHashY)),
+              MulLoI(AddI(k, ToInt(k2)), SetI(kLatticeHashZ)));
+  I h3 = Hash(seed, MulLoI(AddI(i, SetI(1)), SetI(kLatticeHashX)),
+              MulLoI(AddI(j, SetI(1)), SetI(kLatticeHashY)),
+              MulLoI(AddI(k, SetI(1)), SetI(kLatticeHashZ)));
+
+  F n = Add(Add(Add(SimplexCorner3(h0, x0, y0, z0),
+                    SimplexCorner3(h1, x1, y1, z1)),
+                SimplexCorner3(h2, x2, y2, z2)),
+            SimplexCorner3(h3, x3, y3, z3));
+  return Mul(Set(kSimplexScale3D), n);
+}
+
+NOISE_TARGET size_t Fractal2D(const float* x, const float* y, size_t count,
+                              const uint32_t* octave_seeds,
+                              const FractalSettings& settings, float* out) {
+  bool simplex = settings.basis == NoiseBasis::Simplex;
+  size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    F px = Load(x + i);
+    F py = Load(y + i);
+    F sum = Set(0.0f);
+    float amplitude = 1.0f;
+    float total_amplitude = 0.0f;
+    for (int octave = 0; octave < settings.octaves; octave++) {
+      I seed = SetI(octave_seeds[octave]);
+      F n = simplex ? Simplex2D(px, py, seed) : Gradient2D(px, py, seed);
+      sum = Add(sum, Mul(Set(amplitude), n));
+      total_amplitude += amplitude;
+      px = Mul(px, Set(settings.lacunarity));
+      py = Mul(py, Set(settings.lacunarity));
+      amplitude *= settings.gain;
+    }
+    Store(out + i, total_amplitude > 0.0f ? Div(sum, Set(total_amplitude))
+                                          : Set(0.0f));
+  }
+  return i;
+}
+
+NOISE_TARGET size_t Fractal3D(const float* x, const float* y, const float* z,
+                              size_t count, const uint32_t* octave_seeds,
+                              const FractalSettings& settings, float* out) {
+  bool simplex = settings.basis == NoiseBasis::Simplex;
+  size_t i = 0;
+  for (; i + kWidth <= count; i += kWidth) {
+    F px = Load(x + i);
+    F py = Load(y + i);
+    F pz = Load(z + i);
+    F sum = Set(0.0f);
+    float amplitude = 1.0f;
+    float total_amplitude = 0.0f;
+    for (int octave = 0; octave < settings.octaves; octave++) {
+      I seed = SetI(octave_seeds[octave]);
+      F n = simplex ? Simplex3D(px, py, pz, seed)
+                    : Gradient3D(px, py, pz, seed);
+      sum = Add(sum, Mul(Set(amplitude), n));
+      total_amplitude += amplitude;
+      px = Mul(px, Set(settings.lacunarity));
+      py = Mul(py, Set(settings.lacunarity));
+      pz = Mul(pz, Set(settings.lacunarity));
+      amplitude *= settings.gain;
+    }
+    Store(out + i, total_amplitude > 0.0f ? Div(sum, Set(total_amplitude))
+                                          : Set(0.0f));
+  }
+  return i;
+}
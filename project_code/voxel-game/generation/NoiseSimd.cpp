@@ -0,0 +1,217 @@
+#include "NoiseKernels.hpp"
+
+// SSE2 and AVX2 instantiations of NoiseKernels.inl. SSE2 is part of every
+// x86-64 CPU; the AVX2 functions are compiled for AVX2 through a function
+// attribute rather than a per-file flag, so the rest of the program still
+// runs anywhere and Noise.cpp only calls them after checking the CPU.
+// Neither enables FMA, which would round differently from the scalar code.
+
+#ifdef VOXEL_NOISE_X86
+
+#include <immintrin.h>
+
+namespace GLOO {
+namespace noise_sse2 {
+#define NOISE_TARGET
+
+typedef __m128 F;
+typedef __m128i I;
+const size_t kWidth = 4;
+
+inline F Load(const float* p) {
+  return _mm_loadu_ps(p);
+}
+inline void Store(float* p, F v) {
+  _mm_storeu_ps(p, v);
+}
+inline F Set(float v) {
+  return _mm_set1_ps(v);
+}
+inline F Add(F a, F b) {
+  return _mm_add_ps(a, b);
+}
+inline F Sub(F a, F b) {
+  return _mm_sub_ps(a, b);
+}
+inline F Mul(F a, F b) {
+  return _mm_mul_ps(a, b);
+}
+inline F Div(F a, F b) {
+  return _mm_div_ps(a, b);
+}
+inline F Max(F a, F b) {
+  return _mm_max_ps(a, b);
+}
+inline F And(F a, F b) {
+  return _mm_and_ps(a, b);
+}
+inline F AndNot(F a, F b) {
+  return _mm_andnot_ps(a, b);
+}
+inline F Or(F a, F b) {
+  return _mm_or_ps(a, b);
+}
+inline F Xor(F a, F b) {
+  return _mm_xor_ps(a, b);
+}
+// mask ? a : b, per lane.
+inline F Select(F mask, F a, F b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+inline F Greater(F a, F b) {
+  return _mm_cmpgt_ps(a, b);
+}
+inline F GreaterEqual(F a, F b) {
+  return _mm_cmpge_ps(a, b);
+}
+// SSE2 has no rounding instruction: truncate, then step down where that
+// rounded up. Exact for all inputs the lattice can index.
+inline F Floor(F v) {
+  F truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v));
+  return _mm_sub_ps(truncated,
+                    _mm_and_ps(_mm_cmpgt_ps(truncated, v), _mm_set1_ps(1.0f)));
+}
+inline I ToInt(F v) {
+  return _mm_cvttps_epi32(v);
+}
+inline F AsFloat(I v) {
+  return _mm_castsi128_ps(v);
+}
+
+inline I SetI(uint32_t v) {
+  return _mm_set1_epi32(static_cast<int>(v));
+}
+inline I AddI(I a, I b) {
+  return _mm_add_epi32(a, b);
+}
+inline I AndI(I a, I b) {
+  return _mm_and_si128(a, b);
+}
+inline I XorI(I a, I b) {
+  return _mm_xor_si128(a, b);
+}
+inline F EqualI(I a, I b) {
+  return _mm_castsi128_ps(_mm_cmpeq_epi32(a, b));
+}
+template <int count>
+inline I ShiftLeftI(I v) {
+  return _mm_slli_epi32(v, count);
+}
+template <int count>
+inline I ShiftRightI(I v) {
+  return _mm_srli_epi32(v, count);
+}
+// Low 32 bits of each product; SSE2 only multiplies the even lanes into
+// 64 bits, so multiply the odd ones separately and interleave.
+inline I MulLoI(I a, I b) {
+  I even = _mm_mul_epu32(a, b);
+  I odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+#include "NoiseKernels.inl"
+
+#undef NOISE_TARGET
+}  // namespace noise_sse2
+
+namespace noise_avx2 {
+#if defined(__GNUC__) || defined(__clang__)
+#define NOISE_TARGET __attribute__((target("avx2")))
+#else
+#define NOISE_TARGET
+#endif
+
+typedef __m256 F;
+typedef __m256i I;
+const size_t kWidth = 8;
+
+NOISE_TARGET inline F Load(const float* p) {
+  return _mm256_loadu_ps(p);
+}
+NOISE_TARGET inline void Store(float* p, F v) {
+  _mm256_storeu_ps(p, v);
+}
+NOISE_TARGET inline F Set(float v) {
+  return _mm256_set1_ps(v);
+}
+NOISE_TARGET inline F Add(F a, F b) {
+  return _mm256_add_ps(a, b);
+}
+NOISE_TARGET inline F Sub(F a, F b) {
+  return _mm256_sub_ps(a, b);
+}
+NOISE_TARGET inline F Mul(F a, F b) {
+  return _mm256_mul_ps(a, b);
+}
+NOISE_TARGET inline F Div(F a, F b) {
+  return _mm256_div_ps(a, b);
+}
+NOISE_TARGET inline F Max(F a, F b) {
+  return _mm256_max_ps(a, b);
+}
+NOISE_TARGET inline F And(F a, F b) {
+  return _mm256_and_ps(a, b);
+}
+NOISE_TARGET inline F AndNot(F a, F b) {
+  return _mm256_andnot_ps(a, b);
+}
+NOISE_TARGET inline F Or(F a, F b) {
+  return _mm256_or_ps(a, b);
+}
+NOISE_TARGET inline F Xor(F a, F b) {
+  return _mm256_xor_ps(a, b);
+}
+NOISE_TARGET inline F Select(F mask, F a, F b) {
+  return _mm256_blendv_ps(b, a, mask);
+}
+NOISE_TARGET inline F Greater(F a, F b) {
+  return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+}
+NOISE_TARGET inline F GreaterEqual(F a, F b) {
+  return _mm256_cmp_ps(a, b, _CMP_GE_OQ);
+}
+NOISE_TARGET inline F Floor(F v) {
+  return _mm256_floor_ps(v);
+}
+NOISE_TARGET inline I ToInt(F v) {
+  return _mm256_cvttps_epi32(v);
+}
+NOISE_TARGET inline F AsFloat(I v) {
+  return _mm256_castsi256_ps(v);
+}
+
+NOISE_TARGET inline I SetI(uint32_t v) {
+  return _mm256_set1_epi32(static_cast<int>(v));
+}
+NOISE_TARGET inline I AddI(I a, I b) {
+  return _mm256_add_epi32(a, b);
+}
+NOISE_TARGET inline I AndI(I a, I b) {
+  return _mm256_and_si256(a, b);
+}
+NOISE_TARGET inline I XorI(I a, I b) {
+  return _mm256_xor_si256(a, b);
+}
+NOISE_TARGET inline F EqualI(I a, I b) {
+  return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b));
+}
+template <int count>
+NOISE_TARGET inline I ShiftLeftI(I v) {
+  return _mm256_slli_epi32(v, count);
+}
+template <int count>
+NOISE_TARGET inline I ShiftRightI(I v) {
+  return _mm256_srli_epi32(v, count);
+}
+NOISE_TARGET inline I MulLoI(I a, I b) {
+  return _mm256_mullo_epi32(a, b);
+}
+
+#include "NoiseKernels.inl"
+
+#undef NOISE_TARGET
+}  // namespace noise_avx2
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,375 @@
+#include "TerrainGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+namespace GLOO {
+namespace {
+// Streams for DeriveSeed, one per noise field.
+const uint32_t kHeightStream = 1;
+const uint32_t kCaveStream = 2;
+const uint32_t kTreeStream = 3;
+
+// Caves are squashed vertically so they run more sideways than down.
+const float kCaveVerticalStretch = 0.6f;
+
+static_assert(kChunkSize % kCoarseDensityStepXZ == 0 &&
+                  kChunkSize % kCoarseDensityStepY == 0,
+              "The coarse density lattice must line up with chunk borders!");
+// Coarse lattice points along a chunk, the points on both borders included.
+const int kLatticeSizeXZ = kChunkSize / kCoarseDensityStepXZ + 1;
+const int kLatticeSizeY = kChunkSize / kCoarseDensityStepY + 1;
+const int kLatticeLayerSize = kLatticeSizeXZ * kLatticeSizeXZ;
+
+// Trees are a trunk of 4 to 6 wood blocks under a canopy of leaves reaching
+// up to kCanopyRadius columns out and two blocks above the trunk.
+const int kMinTrunkHeight = 4;
+const int kTrunkHeightRange = 3;
+const int kCanopyRadius = 2;
+const int kCanopyHeight = 2;
+static_assert(kCanopyRadius < kChunkSize,
+              "Trees may only reach into adjacent chunks!");
+
+struct Tree {
+  // World position of the lowest trunk block.
+  glm::ivec3 base;
+  int trunk_height;
+};
+
+// Folds a 64-bit seed into 32 bits without dropping either half.
+uint32_t FoldSeed(uint64_t seed) {
+  return HashLattice(static_cast<int32_t>(seed & 0xffffffffu),
+                     static_cast<int32_t>(seed >> 32), 0, 0x2545f491u);
+}
+
+// out = a + (b - a) * t, element-wise. A plain loop over contiguous arrays
+// of a size known at compile time, which the compiler vectorizes.
+void Lerp(const float* a, const float* b, float t, float* out) {
+  for (int i = 0; i < kChunkSize; i++)
+    out[i] = a[i] + (b[i] - a[i]) * t;
+}
+
+// Interpolates one layer of the coarse lattice, x fastest, to every column
+// of the chunk: along x for each lattice row, then between those rows.
+void ExpandLatticeLayer(const float* layer, float* plane) {
+  const float kStep = 1.0f / kCoarseDensityStepXZ;
+  float rows[kLatticeSizeXZ][kChunkSize];
+  for (int lz = 0; lz < kLatticeSizeXZ; lz++) {
+    const float* points = layer + lz * kLatticeSizeXZ;
+    for (int cell = 0; cell < kLatticeSizeXZ - 1; cell++) {
+      float a = points[cell];
+      float b = points[cell + 1];
+      for (int i = 0; i < kCoarseDensityStepXZ; i++)
+        rows[lz][cell * kCoarseDensityStepXZ + i] = a + (b - a) * (i * kStep);
+    }
+  }
+  for (int z = 0; z < kChunkSize; z++) {
+    int lz = z / kCoarseDensityStepXZ;
+    Lerp(rows[lz], rows[lz + 1], (z % kCoarseDensityStepXZ) * kStep,
+         plane + z * kChunkSize);
+  }
+}
+
+// Whether the canopy of a tree whose trunk ends at top has leaves at the
+// given offset from the top trunk block: two wide layers around the top of
+// the trunk, then a square and a cross above it.
+bool IsCanopy(int dx, int dy, int dz) {
+  int ax = std::abs(dx), az = std::abs(dz);
+  if (dy == -1 || dy == 0)
+    return ax <= kCanopyRadius && az <= kCanopyRadius &&
+           !(ax == kCanopyRadius && az == kCanopyRadius);
+  if (dy == 1)
+    return ax <= 1 && az <= 1;
+  return dy == kCanopyHeight && ax + az <= 1;
+}
+}  // namespace
+
+TerrainGenerator::TerrainGenerator(uint64_t seed,
+                                   const TerrainSettings& settings)
+    : seed_(FoldSeed(seed)),
+      height_seed_(DeriveSeed(seed_, kHeightStream)),
+      cave_seed_(DeriveSeed(seed_, kCaveStream)),
+      tree_seed_(DeriveSeed(seed_, kTreeStream)),
+      settings_(settings) {
+}
+
+int TerrainGenerator::GetSurfaceHeight(int x, int z) const {
+  float scale = 1.0f / settings_.height_scale;
+  return ToSurfaceHeight(FractalNoise2D(x * scale, z * scale, height_seed_,
+                                        settings_.height_noise));
+}
+
+int TerrainGenerator::ToSurfaceHeight(float noise) const {
+  return static_cast<int>(std::floor(settings_.base_height +
+                                     settings_.height_amplitude * noise));
+}
+
+void TerrainGenerator::ComputeHeightmap(const ChunkCoord& coord,
+                                        ChunkHeightmap& heightmap) const {
+  const int kColumns = kChunkSize * kChunkSize;
+  glm::ivec3 origin = ChunkOrigin(coord);
+  float scale = 1.0f / settings_.height_scale;
+  float xs[kColumns];
+  float zs[kColumns];
+  for (int z = 0; z < kChunkSize; z++) {
+    for (int x = 0; x < kChunkSize; x++) {
+      xs[x + z * kChunkSize] = (origin.x + x) * scale;
+      zs[x + z * kChunkSize] = (origin.z + z) * scale;
+    }
+  }
+  float noise[kColumns];
+  EvaluateFractalNoise2D(xs, zs, kColumns, height_seed_,
+                         settings_.height_noise, noise);
+  for (int i = 0; i < kColumns; i++)
+    heightmap.heights[i] = ToSurfaceHeight(noise[i]);
+  heightmap.min_height =
+      *std::min_element(heightmap.heights, heightmap.heights + kColumns);
+  heightmap.max_height =
+      *std::max_element(heightmap.heights, heightmap.heights + kColumns);
+}
+
+void TerrainGenerator::GetCaveRow(const glm::ivec3& row_origin,
+                                  float* density) const {
+  float scale = 1.0f / settings_.cave_scale;
+  float xs[kChunkSize];
+  float ys[kChunkSize];
+  float zs[kChunkSize];
+  for (int x = 0; x < kChunkSize; x++) {
+    xs[x] = (row_origin.x + x) * scale;
+    ys[x] = row_origin.y * scale / kCaveVerticalStretch;
+    zs[x] = row_origin.z * scale;
+  }
+  EvaluateFractalNoise3D(xs, ys, zs, kChunkSize, cave_seed_,
+                         settings_.cave_noise, density);
+}
+
+void TerrainGenerator::GetCaveLattice(const glm::ivec3& origin,
+                                      int layer_count, float* lattice) const {
+  const int kMaxPoints = kLatticeSizeY * kLatticeLayerSize;
+  float scale = 1.0f / settings_.cave_scale;
+  float xs[kMaxPoints];
+  float ys[kMaxPoints];
+  float zs[kMaxPoints];
+  int count = 0;
+  // The same expressions as GetCaveRow, so lattice points come out exactly
+  // as full sampling would have them.
+  for (int ly = 0; ly < layer_count; ly++) {
+    int world_y = origin.y + ly * kCoarseDensityStepY;
+    for (int lz = 0; lz < kLatticeSizeXZ; lz++) {
+      for (int lx = 0; lx < kLatticeSizeXZ; lx++, count++) {
+        xs[count] = (origin.x + lx * kCoarseDensityStepXZ) * scale;
+        ys[count] = world_y * scale / kCaveVerticalStretch;
+        zs[count] = (origin.z + lz * kCoarseDensityStepXZ) * scale;
+      }
+    }
+  }
+  EvaluateFractalNoise3D(xs, ys, zs, count, cave_seed_, settings_.cave_noise,
+                         lattice);
+}
+
+void TerrainGenerator::FillTerrain(Chunk& chunk,
+                                   const ChunkHeightmap& heightmap) const {
+  glm::ivec3 origin = chunk.GetOrigin();
+  // Chunks above the terrain and the sea stay empty, and chunks below the
+  // lowest column are solid, without visiting a voxel.
+  if (origin.y > std::max(heightmap.max_height, settings_.sea_level - 1))
+    return;
+  if (origin.y + kChunkSize - 1 <= heightmap.min_height) {
+    chunk.Fill(Voxel(VoxelType::Stone));
+    return;
+  }
+  chunk.EditRegion(
+      glm::ivec3(0), glm::ivec3(kChunkSize),
+      [&](int x, int y, int z, VoxelType) -> VoxelType {
+        int world_y = origin.y + y;
+        if (world_y <= heightmap.Get(x, z))
+          return VoxelType::Stone;
+        return world_y < settings_.sea_level ? VoxelType::Water
+                                             : VoxelType::Air;
+      });
+}
+
+void TerrainGenerator::CarveCaves(Chunk& chunk,
+                                  const ChunkHeightmap& heightmap) const {
+  glm::ivec3 origin = chunk.GetOrigin();
+  // Cave noise is the expensive part, so it is only evaluated for rows that
+  // reach below the soil somewhere: the bottom row_counts[z] rows of each z.
+  int row_counts[kChunkSize];
+  int max_row_count = 0;
+  for (int z = 0; z < kChunkSize; z++) {
+    const int* row_heights = heightmap.heights + z * kChunkSize;
+    int soil_bottom =
+        *std::max_element(row_heights, row_heights + kChunkSize) -
+        settings_.soil_depth;
+    row_counts[z] = std::min(std::max(soil_bottom - origin.y, 0), kChunkSize);
+    max_row_count = std::max(max_row_count, row_counts[z]);
+  }
+  if (max_row_count == 0)
+    return;
+
+  auto carve_row = [&](int y, int z, const float* density) {
+    const int* row_heights = heightmap.heights + z * kChunkSize;
+    int world_y = origin.y + y;
+    chunk.EditRegion(
+        glm::ivec3(0, y, z), glm::ivec3(kChunkSize, y + 1, z + 1),
+        [&](int x, int, int, VoxelType current) -> VoxelType {
+          bool below_soil = world_y < row_heights[x] - settings_.soil_depth;
+          return density[x] > settings_.cave_threshold && below_soil
+                     ? VoxelType::Air
+                     : current;
+        });
+  };
+  float density[kChunkSize];
+
+  if (settings_.cave_sampling == DensitySampling::Full) {
+    for (int z = 0; z < kChunkSize; z++) {
+      for (int y = 0; y < row_counts[z]; y++) {
+        GetCaveRow(origin + glm::ivec3(0, y, z), density);
+        carve_row(y, z, density);
+      }
+    }
+    return;
+  }
+
+  // Only the lattice layers up to the highest row needed. The lattice is
+  // aligned to world coordinates, so neighbouring chunks sample the points
+  // on their shared border identically and caves continue seamlessly.
+  int cell_count = (max_row_count + kCoarseDensityStepY - 1) /
+                   kCoarseDensityStepY;
+  float lattice[kLatticeSizeY * kLatticeLayerSize];
+  GetCaveLattice(origin, cell_count + 1, lattice);
+  // The x-z planes of the lattice layers below and above the current row.
+  float planes[2][kChunkSize * kChunkSize];
+  float* below = planes[0];
+  float* above = planes[1];
+  ExpandLatticeLayer(lattice, above);
+  for (int y = 0; y < max_row_count; y++) {
+    int cell = y / kCoarseDensityStepY;
+    if (y % kCoarseDensityStepY == 0) {
+      std::swap(below, above);
+      ExpandLatticeLayer(lattice + (cell + 1) * kLatticeLayerSize, above);
+    }
+    float t = (y % kCoarseDensityStepY) * (1.0f / kCoarseDensityStepY);
+    for (int z = 0; z < kChunkSize; z++) {
+      if (y >= row_counts[z])
+        continue;
+      Lerp(below + z * kChunkSize, above + z * kChunkSize, t, density);
+      carve_row(y, z, density);
+    }
+  }
+}
+
+void TerrainGenerator::CoverSurface(Chunk& chunk,
+                                    const ChunkHeightmap& heightmap) const {
+  glm::ivec3 origin = chunk.GetOrigin();
+  int min_y =
+      std::max(heightmap.min_height - settings_.soil_depth - origin.y, 0);
+  int max_y = std::min(heightmap.max_height - origin.y + 1, kChunkSize);
+  if (min_y >= max_y)
+    return;
+  chunk.EditRegion(
+      glm::ivec3(0, min_y, 0), glm::ivec3(kChunkSize, max_y, kChunkSize),
+      [&](int x, int y, int z, VoxelType current) -> VoxelType {
+        int surface_height = heightmap.Get(x, z);
+        int depth = surface_height - (origin.y + y);
+        if (depth < 0 || depth > settings_.soil_depth)
+          return current;
+        // Sea beds and columns that end just above the water are sand.
+        if (surface_height <= settings_.sea_level + 1)
+          return VoxelType::Sand;
+        return depth == 0 ? VoxelType::Grass : VoxelType::Dirt;
+      });
+}
+
+void TerrainGenerator::PlaceTrees(
+    Chunk& chunk, const ChunkHeightmap* const neighbors[9]) const {
+  glm::ivec3 origin = chunk.GetOrigin();
+  const int kMaxTreeHeight =
+      kMinTrunkHeight + kTrunkHeightRange - 1 + kCanopyHeight;
+  uint32_t threshold = static_cast<uint32_t>(
+      std::min(settings_.tree_density, 1.0f) * 16777216.0f);
+
+  std::vector<Tree> trees;
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      const ChunkHeightmap& heightmap = *neighbors[(dx + 1) + 3 * (dz + 1)];
+      // Skip neighbours none of whose trees can reach the chunk vertically.
+      if (heightmap.max_height + kMaxTreeHeight < origin.y ||
+          heightmap.min_height >= origin.y + kChunkSize)
+        continue;
+      // Only columns within the canopy radius of the chunk matter.
+      int x_min = dx < 0 ? kChunkSize - kCanopyRadius : 0;
+      int x_max = dx > 0 ? kCanopyRadius : kChunkSize;
+      int z_min = dz < 0 ? kChunkSize - kCanopyRadius : 0;
+      int z_max = dz > 0 ? kCanopyRadius : kChunkSize;
+      for (int z = z_min; z < z_max; z++) {
+        for (int x = x_min; x < x_max; x++) {
+          int surface_height = heightmap.Get(x, z);
+          // Trees grow on grass only.
+          if (surface_height <= settings_.sea_level + 1)
+            continue;
+          glm::ivec3 base(origin.x + dx * kChunkSize + x, surface_height + 1,
+                          origin.z + dz * kChunkSize + z);
+          uint32_t hash = HashLattice(base.x, base.z, 0, tree_seed_);
+          if ((hash & 0xffffff) >= threshold)
+            continue;
+          int trunk_height =
+              kMinTrunkHeight + static_cast<int>((hash >> 24) %
+                                                 kTrunkHeightRange);
+          if (base.y > origin.y + kChunkSize - 1 ||
+              base.y + trunk_height - 1 + kCanopyHeight < origin.y)
+            continue;
+          trees.push_back({base, trunk_height});
+        }
+      }
+    }
+  }
+
+  // Leaves go into air only and trunks into air or leaves, so overlapping
+  // trees come out the same whatever order they are placed in.
+  auto place = [&](const glm::ivec3& position, VoxelType type) {
+    glm::ivec3 local = position - origin;
+    if (glm::any(glm::lessThan(local, glm::ivec3(0))) ||
+        glm::any(glm::greaterThanEqual(local, glm::ivec3(kChunkSize))))
+      return;
+    VoxelType current = chunk.Get(local.x, local.y, local.z).getType();
+    if (current == VoxelType::Air ||
+        (type == VoxelType::Wood && current == VoxelType::Leaves))
+      chunk.Set(local.x, local.y, local.z, Voxel(type));
+  };
+  for (const Tree& tree : trees) {
+    glm::ivec3 top = tree.base + glm::ivec3(0, tree.trunk_height - 1, 0);
+    for (int dy = -1; dy <= kCanopyHeight; dy++)
+      for (int dz = -kCanopyRadius; dz <= kCanopyRadius; dz++)
+        for (int dx = -kCanopyRadius; dx <= kCanopyRadius; dx++)
+          if (IsCanopy(dx, dy, dz))
+            place(top + glm::ivec3(dx, dy, dz), VoxelType::Leaves);
+  }
+  for (const Tree& tree : trees) {
+    for (int y = 0; y < tree.trunk_height; y++)
+      place(tree.base + glm::ivec3(0, y, 0), VoxelType::Wood);
+  }
+}
+
+void TerrainGenerator::Generate(Chunk& chunk) const {
+  ChunkCoord coord = chunk.GetCoord();
+  ChunkHeightmap heightmaps[9];
+  const ChunkHeightmap* neighbors[9];
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dx = -1; dx <= 1; dx++) {
+      int index = (dx + 1) + 3 * (dz + 1);
+      ComputeHeightmap(coord + glm::ivec3(dx, 0, dz), heightmaps[index]);
+      neighbors[index] = &heightmaps[index];
+    }
+  }
+  const ChunkHeightmap& heightmap = heightmaps[4];
+  FillTerrain(chunk, heightmap);
+  CarveCaves(chunk, heightmap);
+  CoverSurface(chunk, heightmap);
+  PlaceTrees(chunk, neighbors);
+  // Solid stone or all-water chunks need no payload.
+  chunk.Compact();
+}
+}  // namespace GLOO
@@ -0,0 +1,122 @@
+#ifndef TERRAIN_GENERATOR_H_
+#define TERRAIN_GENERATOR_H_
+
+#include <cstdint>
+
+#include "storage/Chunk.hpp"
+
+#include "Noise.hpp"
+
+namespace GLOO {
+// Where 3D density is evaluated.
+enum class DensitySampling {
+  // At every voxel.
+  Full,
+  // On a lattice aligned to world coordinates, every kCoarseDensityStepXZ
+  // voxels in x and z and every kCoarseDensityStepY in y, and trilinearly
+  // interpolated in between. Equal to Full on the lattice itself.
+  Coarse,
+};
+
+const int kCoarseDensityStepXZ = 4;
+const int kCoarseDensityStepY = 8;
+
+// Shape of the generated terrain. Lengths are in voxels.
+struct TerrainSettings {
+  int sea_level = 0;
+  // The surface height is base_height plus fractal noise scaled by
+  // height_amplitude, sampled once per column.
+  float base_height = 6.0f;
+  float height_amplitude = 28.0f;
+  // Horizontal size of the largest hills.
+  float height_scale = 192.0f;
+  FractalSettings height_noise{5, 2.0f, 0.5f};
+  // Caves are where 3D fractal noise exceeds cave_threshold, and only below
+  // the soil, so they rarely break through the surface.
+  float cave_scale = 48.0f;
+  float cave_threshold = 0.42f;
+  FractalSettings cave_noise{2, 2.0f, 0.5f};
+  // Coarse sampling evaluates the cave noise about 80 times less often in
+  // underground chunks. Interpolation flattens the noise peaks caves are
+  // cut from, so they come out smoother and about a third smaller in
+  // volume; noise-benchmark measures both.
+  DensitySampling cave_sampling = DensitySampling::Full;
+  // Dirt (or sand, near the sea) between the surface block and the stone.
+  int soil_depth = 3;
+  // Chance of a tree growing on a grass column.
+  float tree_density = 0.012f;
+};
+
+// Surface heights of the columns of one chunk, x fastest. The same for
+// every chunk stacked in a column.
+struct ChunkHeightmap {
+  int Get(int x, int z) const {
+    return heights[x + z * kChunkSize];
+  }
+
+  int heights[kChunkSize * kChunkSize];
+  int min_height;
+  int max_height;
+};
+
+// Heightmap terrain with caves, water up to sea level, beaches and trees,
+// from a seed alone. Generation reads nothing but the seed, the settings
+// and the chunk's coordinate, so any chunk can be generated on its own, on
+// any thread and in any order, and always comes out bit-identical for a
+// given build and seed.
+//
+// Generation runs in stages, which ChunkGenerationPipeline can schedule
+// separately. Each stage writes only the chunk it is given, and the only
+// thing a stage reads from other chunks is the heightmaps of the eight
+// horizontal neighbours, which trees rooted there but reaching into the
+// chunk need.
+class TerrainGenerator {
+ public:
+  explicit TerrainGenerator(uint64_t seed,
+                            const TerrainSettings& settings = TerrainSettings());
+
+  // Runs every stage on a freshly created, all-air chunk.
+  void Generate(Chunk& chunk) const;
+
+  // The stages, in order.
+  void ComputeHeightmap(const ChunkCoord& coord,
+                        ChunkHeightmap& heightmap) const;
+  // Stone up to the surface and water up to sea level.
+  void FillTerrain(Chunk& chunk, const ChunkHeightmap& heightmap) const;
+  void CarveCaves(Chunk& chunk, const ChunkHeightmap& heightmap) const;
+  // Turns the top of the stone into grass, dirt or sand.
+  void CoverSurface(Chunk& chunk, const ChunkHeightmap& heightmap) const;
+  // Trees rooted in the chunk's columns or its neighbours', whichever part
+  // of them falls inside the chunk. neighbors[(dx + 1) + 3 * (dz + 1)] is
+  // the heightmap of the chunk at horizontal offset (dx, dz).
+  void PlaceTrees(Chunk& chunk,
+                  const ChunkHeightmap* const neighbors[9]) const;
+
+  // World y of the topmost terrain voxel of a column, before caves.
+  int GetSurfaceHeight(int x, int z) const;
+
+  uint32_t GetSeed() const {
+    return seed_;
+  }
+  const TerrainSettings& GetSettings() const {
+    return settings_;
+  }
+
+ private:
+  int ToSurfaceHeight(float noise) const;
+  // Cave density of each voxel of a row along x.
+  void GetCaveRow(const glm::ivec3& row_origin, float* density) const;
+  // Cave density on the coarse lattice points of a chunk's bottom
+  // layer_count lattice layers, x fastest, then z, then y.
+  void GetCaveLattice(const glm::ivec3& origin, int layer_count,
+                      float* lattice) const;
+
+  uint32_t seed_;
+  uint32_t height_seed_;
+  uint32_t cave_seed_;
+  uint32_t tree_seed_;
+  TerrainSettings settings_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,486 @@
+#include "BinaryChunkMesher.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define VOXEL_MESHER_X86 1
+#include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace GLOO {
+namespace {
+const int kPad = PaddedChunkVoxels::kSize;
+const int kColumnCount = kPad * kPad;
+// All bits of a column word.
+const uint64_t kColumnBits = (uint64_t(1) << kPad) - 1;
+// Index strides of the padded voxel array along x, y and z.
+const int kPadStrides[3] = {1, kPad, kPad * kPad};
+// Transparent block types the vector path compares against; registries
+// with more fall back to the opacity table.
+const int kMaxTransparentTypes = 8;
+// Bit planes of a face's AO byte, and at most of its block ID.
+const int kAoBits = 8;
+const int kBlockIdBits = 16;
+
+static_assert(kPad == 34, "Column transposes assume 32 voxels plus border");
+static_assert(kChunkSize == 32, "Slice rows must be exactly 32 bits");
+
+inline int CountTrailingZeros(uint32_t value) {
+#ifdef _MSC_VER
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+// Length of the run of set bits starting at bit 0.
+inline int CountTrailingOnes(uint32_t value) {
+  return value == ~0u ? 32 : CountTrailingZeros(~value);
+}
+
+// Bit i of a column word is padded voxel i along the column's axis, i.e.
+// local coordinate i - 1. Columns along an axis are indexed by the two
+// other padded coordinates, lower axis first. The x columns are read off
+// the padded rows; the y and z columns are bit-matrix transposes of them.
+struct ColumnMasks {
+  uint64_t solid[3][kColumnCount];
+  uint64_t opaque[3][kColumnCount];
+  // Whether any voxel is solid but not opaque, and whether all such
+  // voxels have the same type, in which case a face between two of them
+  // never shows.
+  bool any_transparent;
+  bool one_transparent_type;
+};
+
+#ifdef VOXEL_MESHER_X86
+// Gathers the lanes of five compare results over one padded row, covering
+// voxels 0-7, 8-15, 16-23, 24-31 and 26-33, into a column word.
+inline uint64_t LaneBits(__m128i a, __m128i b, __m128i c, __m128i d,
+                         __m128i e) {
+  uint32_t low =
+      static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(a, b))) |
+      static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(c, d))) << 16;
+  uint32_t high =
+      static_cast<uint32_t>(_mm_movemask_epi8(_mm_packs_epi16(e, e))) >> 6 &
+      3u;
+  return uint64_t(low) | uint64_t(high) << 32;
+}
+
+// Eight block IDs per compare: solid is "not air", and transparent a match
+// against any transparent type. The transparent bits go into the opaque
+// columns for now; see BuildColumnMasks.
+void BuildRowMasks(const BlockId* data, const BlockId* transparent,
+                   int transparent_count, ColumnMasks& masks) {
+  const __m128i air = _mm_setzero_si128();
+  __m128i keys[kMaxTransparentTypes];
+  __m128i seen[kMaxTransparentTypes];
+  for (int i = 0; i < transparent_count; i++) {
+    keys[i] = _mm_set1_epi16(static_cast<short>(transparent[i]));
+    seen[i] = _mm_setzero_si128();
+  }
+  for (int row = 0; row < kColumnCount; row++) {
+    const BlockId* p = data + row * kPad;
+    __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+    __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    __m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 24));
+    __m128i v4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 26));
+    uint64_t solid =
+        ~LaneBits(_mm_cmpeq_epi16(v0, air), _mm_cmpeq_epi16(v1, air),
+                  _mm_cmpeq_epi16(v2, air), _mm_cmpeq_epi16(v3, air),
+                  _mm_cmpeq_epi16(v4, air)) &
+        kColumnBits;
+    masks.solid[0][row] = solid;
+    masks.opaque[0][row] = 0;
+    if (solid == 0)
+      continue;
+    __m128i t0 = _mm_setzero_si128(), t1 = t0, t2 = t0, t3 = t0, t4 = t0;
+    for (int i = 0; i < transparent_count; i++) {
+      __m128i e0 = _mm_cmpeq_epi16(v0, keys[i]);
+      __m128i e1 = _mm_cmpeq_epi16(v1, keys[i]);
+      __m128i e2 = _mm_cmpeq_epi16(v2, keys[i]);
+      __m128i e3 = _mm_cmpeq_epi16(v3, keys[i]);
+      __m128i e4 = _mm_cmpeq_epi16(v4, keys[i]);
+      t0 = _mm_or_si128(t0, e0);
+      t1 = _mm_or_si128(t1, e1);
+      t2 = _mm_or_si128(t2, e2);
+      t3 = _mm_or_si128(t3, e3);
+      t4 = _mm_or_si128(t4, e4);
+      seen[i] = _mm_or_si128(
+          seen[i], _mm_or_si128(_mm_or_si128(e0, e1),
+                                _mm_or_si128(_mm_or_si128(e2, e3), e4)));
+    }
+    masks.opaque[0][row] = LaneBits(t0, t1, t2, t3, t4);
+  }
+  int types_seen = 0;
+  for (int i = 0; i < transparent_count; i++)
+    types_seen += _mm_movemask_epi8(seen[i]) != 0;
+  masks.any_transparent = types_seen > 0;
+  masks.one_transparent_type = types_seen == 1;
+}
+#endif
+
+// One opacity table lookup per voxel, for registries with many transparent
+// types or targets without the vector path.
+void BuildRowMasksScalar(const BlockId* data, const uint8_t* opaque_table,
+                         ColumnMasks& masks) {
+  bool any_transparent = false;
+  for (int row = 0; row < kColumnCount; row++) {
+    const BlockId* p = data + row * kPad;
+    uint64_t solid = 0;
+    uint64_t opaque = 0;
+    for (int x = 0; x < kPad; x++) {
+      solid |= uint64_t(p[x] != static_cast<BlockId>(VoxelType::Air)) << x;
+      opaque |= uint64_t(opaque_table[p[x]] != 0) << x;
+    }
+    masks.solid[0][row] = solid;
+    masks.opaque[0][row] = solid & ~opaque;
+    any_transparent |= solid != opaque;
+  }
+  masks.any_transparent = any_transparent;
+  masks.one_transparent_type = false;
+}
+
+// Transposes a 34x34 bit matrix: bit j of out[i] becomes bit i of the
+// in_stride-spaced row j. Rows 0-31 are transposed as two 32x32 matrices
+// side by side in one word, bits 0-31 in the low halves and the border
+// bits 32-33 in the high halves; rows 32-33 ride along in the high halves
+// of rows 0-1, where they land in bits 32-33 of the output. Only the 2x2
+// block where the two meet needs fixing up.
+void TransposeColumns34(const uint64_t* in, int in_stride, uint64_t* out) {
+  uint64_t rows[32];
+  uint64_t any = 0;
+  uint64_t all = kColumnBits;
+  for (int r = 0; r < 32; r++) {
+    rows[r] = in[r * in_stride];
+    any |= rows[r];
+    all &= rows[r];
+  }
+  uint64_t in0 = rows[0];
+  uint64_t in1 = rows[1];
+  uint64_t edge0 = in[32 * in_stride];
+  uint64_t edge1 = in[33 * in_stride];
+  any |= edge0 | edge1;
+  all &= edge0 & edge1;
+  // Empty slices above the terrain and full ones below it.
+  if (any == 0 || all == kColumnBits) {
+    for (int c = 0; c < kPad; c++)
+      out[c] = any == 0 ? 0 : kColumnBits;
+    return;
+  }
+
+  rows[0] = (in0 & 0xFFFFFFFFull) | edge0 << 32;
+  rows[1] = (in1 & 0xFFFFFFFFull) | edge1 << 32;
+  uint64_t mask = 0x0000FFFF0000FFFFull;
+  for (int j = 16; j != 0; j >>= 1, mask ^= mask << j) {
+    for (int k = 0; k < 32; k = ((k | j) + 1) & ~j) {
+      uint64_t t = ((rows[k] >> j) ^ rows[k | j]) & mask;
+      rows[k | j] ^= t;
+      rows[k] ^= t << j;
+    }
+  }
+  for (int c = 0; c < 32; c++)
+    out[c] = rows[c] & kColumnBits;
+  for (int c = 0; c < 2; c++) {
+    int bit = 32 + c;
+    out[bit] = (rows[c] >> 32 & ~uint64_t(3)) | (in0 >> bit & 1) |
+               (in1 >> bit & 1) << 1 | (edge0 >> bit & 1) << 32 |
+               (edge1 >> bit & 1) << 33;
+  }
+}
+
+// Derives the y columns from the x columns by transposing each z slice
+// (rows indexed by y), and the z columns by transposing each y slice (rows
+// indexed by z).
+void TransposeColumns(uint64_t* columns[3]) {
+  for (int z = 0; z < kPad; z++)
+    TransposeColumns34(columns[0] + z * kPad, 1, columns[1] + z * kPad);
+  for (int y = 0; y < kPad; y++)
+    TransposeColumns34(columns[0] + y, kPad, columns[2] + y * kPad);
+}
+
+void BuildColumnMasks(const BlockId* data, const uint8_t* opaque_table,
+                      ColumnMasks& masks) {
+  bool vector_path = false;
+#ifdef VOXEL_MESHER_X86
+  const BlockRegistry& registry = BlockRegistry::GetInstance();
+  BlockId transparent_types[kMaxTransparentTypes];
+  int transparent_count = 0;
+  vector_path = true;
+  for (size_t id = 1; id < registry.GetBlockCount(); id++) {
+    if (opaque_table[id])
+      continue;
+    if (transparent_count == kMaxTransparentTypes) {
+      vector_path = false;
+      break;
+    }
+    transparent_types[transparent_count++] = static_cast<BlockId>(id);
+  }
+  if (vector_path)
+    BuildRowMasks(data, transparent_types, transparent_count, masks);
+#endif
+  if (!vector_path)
+    BuildRowMasksScalar(data, opaque_table, masks);
+
+  uint64_t* solid[3] = {masks.solid[0], masks.solid[1], masks.solid[2]};
+  TransposeColumns(solid);
+  // Without transparent blocks the opaque columns equal the solid ones.
+  if (!masks.any_transparent) {
+    std::memcpy(masks.opaque, masks.solid, sizeof(masks.solid));
+    return;
+  }
+  // Transparent voxels are usually few, so transposing them rather than the
+  // opaque ones skips more empty slices.
+  uint64_t* transparent[3] = {masks.opaque[0], masks.opaque[1],
+                              masks.opaque[2]};
+  TransposeColumns(transparent);
+  for (int axis = 0; axis < 3; axis++) {
+    for (int i = 0; i < kColumnCount; i++)
+      masks.opaque[axis][i] = masks.solid[axis][i] & ~masks.opaque[axis][i];
+  }
+}
+
+// AO bytes of a face indexed by the opacity of the 3x3 voxels in front of
+// it: bits 0-2 are the row below it at u - 1, u and u + 1, bits 3-5 the
+// row it is on, and bits 6-8 the row above. Bit 4, the voxel right in front,
+// is never opaque for a visible face and is ignored.
+struct FaceAoTable {
+  uint8_t ao[512];
+
+  FaceAoTable() {
+    for (int i = 0; i < 512; i++) {
+      int below_lo = i & 1, below = i >> 1 & 1, below_hi = i >> 2 & 1;
+      int lo = i >> 3 & 1, hi = i >> 5 & 1;
+      int above_lo = i >> 6 & 1, above = i >> 7 & 1, above_hi = i >> 8 & 1;
+      ao[i] = static_cast<uint8_t>(CornerAo(lo, below, below_lo) |
+                                   CornerAo(hi, below, below_hi) << 2 |
+                                   CornerAo(hi, above, above_hi) << 4 |
+                                   CornerAo(lo, above, above_lo) << 6);
+    }
+  }
+};
+
+const FaceAoTable& GetFaceAoTable() {
+  static const FaceAoTable table;
+  return table;
+}
+
+// AO of one corner for 32 faces at once, as the low and high bit of
+// CornerAo: 3 with no occluder, 2 with one, 1 with a side and the
+// diagonal, and 0 with both sides.
+inline void CornerAoPlanes(uint32_t side_a, uint32_t side_b, uint32_t diagonal,
+                           uint32_t& low, uint32_t& high) {
+  high = ~((side_a & side_b) | ((side_a | side_b) & diagonal));
+  low = ~(side_a | side_b | diagonal) | (diagonal & (side_a ^ side_b));
+}
+
+// One slice of one face direction, with bit u of row v standing for the
+// face at (u, v): the visible faces, the bit planes of their AO bytes and
+// block IDs, and the faces the quad starting there may grow over to the
+// next column or row, because they are visible, have the same block and AO,
+// and the AO does not vary along that axis. The planes are only filled in
+// for faces with a visible neighbour in the slice.
+struct SlicePlanes {
+  uint32_t visible[kChunkSize];
+  uint32_t ao[kAoBits][kChunkSize];
+  uint32_t block[kBlockIdBits][kChunkSize];
+  uint32_t grows_u[kChunkSize];
+  uint32_t grows_v[kChunkSize];
+};
+
+// Faces of row v that differ in AO or block from the face at
+// (u + shift, v + row_shift), for shift and row_shift of 0 or 1.
+inline uint32_t DifferingFaces(const SlicePlanes& planes, int v, int row_shift,
+                               int shift, int block_bits) {
+  uint32_t differ = 0;
+  for (int i = 0; i < kAoBits; i++)
+    differ |= planes.ao[i][v] ^ planes.ao[i][v + row_shift] >> shift;
+  for (int i = 0; i < block_bits; i++)
+    differ |= planes.block[i][v] ^ planes.block[i][v + row_shift] >> shift;
+  return differ;
+}
+}  // namespace
+
+void BinaryChunkMesher::CollectGreedyQuads(const PaddedChunkVoxels& voxels,
+                                           std::vector<ChunkQuad>& quads) {
+  const BlockId* data = voxels.GetData();
+  const BlockRegistry& registry = BlockRegistry::GetInstance();
+  const uint8_t* opaque_table = registry.GetOpaqueTable();
+  const uint8_t* ao_table = GetFaceAoTable().ao;
+  ColumnMasks masks;
+  BuildColumnMasks(data, opaque_table, masks);
+
+  int block_bits = 0;
+  while ((size_t(1) << block_bits) < registry.GetBlockCount())
+    block_bits++;
+  SlicePlanes planes;
+  const int origin = PaddedChunkVoxels::Index(0, 0, 0);
+
+  for (int f = 0; f < kBlockFaceCount; f++) {
+    FaceAxes axes = GetFaceAxes(static_cast<BlockFace>(f));
+    int stride_axis = kPadStrides[axes.axis];
+    int stride_u = kPadStrides[axes.u];
+    int stride_v = kPadStrides[axes.v];
+    int neighbor_offset = axes.sign * stride_axis;
+    // Row v of slice d is the u column at padded (d + 1, v + 1).
+    int column_axis = axes.axis < axes.v ? 1 : kPad;
+    int column_v = axes.axis < axes.v ? kPad : 1;
+    const uint64_t* solid = masks.solid[axes.u] + column_v;
+    const uint64_t* opaque = masks.opaque[axes.u] + column_v;
+
+    for (int d = 0; d < kChunkSize; d++) {
+      int slice_column = (d + 1) * column_axis;
+      int front_column = (d + 1 + axes.sign) * column_axis;
+      // Faces between two transparent blocks only show if the types
+      // differ, which is never the case with a single transparent type.
+      uint32_t any_visible = 0;
+      for (int v = 0; v < kChunkSize; v++) {
+        int row = v * column_v;
+        uint64_t visible =
+            solid[slice_column + row] & ~opaque[front_column + row];
+        if (masks.one_transparent_type) {
+          visible &=
+              opaque[slice_column + row] | ~solid[front_column + row];
+        }
+        planes.visible[v] = static_cast<uint32_t>(visible >> 1);
+        any_visible |= planes.visible[v];
+      }
+      if (any_visible == 0)
+        continue;
+      int slice = origin + d * stride_axis;
+
+      if (masks.any_transparent && !masks.one_transparent_type) {
+        for (int v = 0; v < kChunkSize; v++) {
+          if (planes.visible[v] == 0)
+            continue;
+          int row = v * column_v;
+          uint64_t transparent =
+              solid[slice_column + row] & ~opaque[slice_column + row];
+          uint64_t front_transparent =
+              solid[front_column + row] & ~opaque[front_column + row];
+          uint32_t ambiguous =
+              static_cast<uint32_t>((transparent & front_transparent) >> 1);
+          for (; ambiguous != 0; ambiguous &= ambiguous - 1) {
+            int u = CountTrailingZeros(ambiguous);
+            int index = slice + u * stride_u + v * stride_v;
+            if (data[index] == data[index + neighbor_offset])
+              planes.visible[v] &= ~(1u << u);
+          }
+        }
+      }
+
+      for (int v = 0; v < kChunkSize; v++) {
+        uint32_t visible = planes.visible[v];
+        uint32_t neighbors = visible >> 1 | visible << 1;
+        if (v > 0)
+          neighbors |= planes.visible[v - 1];
+        if (v + 1 < kChunkSize)
+          neighbors |= planes.visible[v + 1];
+        uint32_t paired = visible & neighbors;
+        planes.grows_u[v] = 0;
+        if (paired == 0)
+          continue;
+
+        // Bit u of each term is the front voxel at u - 1, u or u + 1 along
+        // the row below, on, or above v.
+        int row = front_column + v * column_v;
+        uint64_t below = opaque[row - column_v];
+        uint64_t front = opaque[row];
+        uint64_t above = opaque[row + column_v];
+        uint32_t lo = static_cast<uint32_t>(front);
+        uint32_t hi = static_cast<uint32_t>(front >> 2);
+        uint32_t below_mid = static_cast<uint32_t>(below >> 1);
+        uint32_t above_mid = static_cast<uint32_t>(above >> 1);
+        CornerAoPlanes(lo, below_mid, static_cast<uint32_t>(below),
+                       planes.ao[0][v], planes.ao[1][v]);
+        CornerAoPlanes(hi, below_mid, static_cast<uint32_t>(below >> 2),
+                       planes.ao[2][v], planes.ao[3][v]);
+        CornerAoPlanes(hi, above_mid, static_cast<uint32_t>(above >> 2),
+                       planes.ao[4][v], planes.ao[5][v]);
+        CornerAoPlanes(lo, above_mid, static_cast<uint32_t>(above),
+                       planes.ao[6][v], planes.ao[7][v]);
+
+        for (int i = 0; i < block_bits; i++)
+          planes.block[i][v] = 0;
+        const BlockId* row_blocks = data + slice + v * stride_v;
+        for (uint32_t bits = paired; bits != 0; bits &= bits - 1) {
+          int u = CountTrailingZeros(bits);
+          uint32_t id = row_blocks[u * stride_u];
+          for (int i = 0; i < block_bits; i++)
+            planes.block[i][v] |= (id >> i & 1u) << u;
+        }
+
+        // Corners 0 and 1, and 3 and 2, are the ends of the face along u.
+        uint32_t pairs_u = visible & visible >> 1;
+        if (pairs_u == 0)
+          continue;
+        uint32_t ao_varies_u = (planes.ao[0][v] ^ planes.ao[2][v]) |
+                               (planes.ao[1][v] ^ planes.ao[3][v]) |
+                               (planes.ao[6][v] ^ planes.ao[4][v]) |
+                               (planes.ao[7][v] ^ planes.ao[5][v]);
+        planes.grows_u[v] = pairs_u & ~ao_varies_u &
+                            ~DifferingFaces(planes, v, 0, 1, block_bits);
+      }
+      // Corners 0 and 3, and 1 and 2, are the ends of the face along v.
+      for (int v = 0; v < kChunkSize; v++) {
+        uint32_t pairs_v =
+            v + 1 < kChunkSize ? planes.visible[v] & planes.visible[v + 1] : 0;
+        planes.grows_v[v] = 0;
+        if (pairs_v == 0)
+          continue;
+        uint32_t ao_varies_v = (planes.ao[0][v] ^ planes.ao[6][v]) |
+                               (planes.ao[1][v] ^ planes.ao[7][v]) |
+                               (planes.ao[2][v] ^ planes.ao[4][v]) |
+                               (planes.ao[3][v] ^ planes.ao[5][v]);
+        planes.grows_v[v] = pairs_v & ~ao_varies_v &
+                            ~DifferingFaces(planes, v, 1, 0, block_bits);
+      }
+
+      // A face is only ever consumed together with the faces below it in
+      // the same quad, so grows_v, unlike the visible rows, never goes
+      // stale.
+      for (int v = 0; v < kChunkSize; v++) {
+        int row = front_column + v * column_v;
+        uint32_t remaining = planes.visible[v];
+        while (remaining != 0) {
+          int u = CountTrailingZeros(remaining);
+          int width = 1 + CountTrailingOnes(
+                              (planes.grows_u[v] & remaining >> 1) >> u);
+          uint32_t span = (width == 32 ? ~0u : (1u << width) - 1) << u;
+          int height = 1;
+          while ((planes.grows_v[v + height - 1] & span) == span)
+            height++;
+          remaining &= ~span;
+          for (int j = 1; j < height; j++)
+            planes.visible[v + j] &= ~span;
+
+          int neighborhood = static_cast<int>(
+              (opaque[row - column_v] >> u & 7) |
+              (opaque[row] >> u & 7) << 3 |
+              (opaque[row + column_v] >> u & 7) << 6);
+          glm::ivec3 corner;
+          corner[axes.axis] = d;
+          corner[axes.u] = u;
+          corner[axes.v] = v;
+          ChunkQuad quad;
+          quad.x = static_cast<uint8_t>(corner.x);
+          quad.y = static_cast<uint8_t>(corner.y);
+          quad.z = static_cast<uint8_t>(corner.z);
+          quad.width = static_cast<uint8_t>(width);
+          quad.height = static_cast<uint8_t>(height);
+          quad.face = static_cast<BlockFace>(f);
+          quad.block = data[slice + u * stride_u + v * stride_v];
+          quad.ao = ao_table[neighborhood];
+          quads.push_back(quad);
+        }
+      }
+    }
+  }
+}
+}  // namespace GLOO
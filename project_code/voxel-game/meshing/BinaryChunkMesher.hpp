@@ -0,0 +1,26 @@
+#ifndef BINARY_CHUNK_MESHER_H_
+#define BINARY_CHUNK_MESHER_H_
+
+#include "ChunkMesher.hpp"
+
+namespace GLOO {
+// Greedy mesher on bitmasks. Each row of the padded chunk is turned into
+// solid and opaque bits with a few vector compares, and the rows are
+// transposed into one 64-bit word per column along the other two axes, so
+// the visible faces of a whole column come out of a shift, an and-not and
+// a mask. Each slice of a face direction is then laid out as 32-bit rows
+// of bit planes: visibility, the two AO bits of every corner and every bit
+// of the block ID. Whether a face can grow into its neighbour along u or v
+// is a handful of and/xor operations over whole rows, and the rows are
+// merged into quads with bit scans.
+//
+// The output is identical, quad for quad and in the same order, to
+// ChunkMesher::CollectGreedyQuads, which stays as the scalar reference.
+class BinaryChunkMesher {
+ public:
+  static void CollectGreedyQuads(const PaddedChunkVoxels& voxels,
+                                 std::vector<ChunkQuad>& quads);
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,207 @@
+#include "ChunkMeshCache.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace GLOO {
+namespace {
+const uint32_t kFileMagic = 0x434D5856;  // "VXMC"
+// Bump whenever the vertex format or the meshers' output changes, so stale
+// files on disk read as misses.
+const uint32_t kFileVersion = 1;
+// One quad per voxel face; anything claiming more is not a mesh file.
+const uint32_t kMaxFileVertices = kBlockFaceCount * kChunkVolume * 4;
+
+// Entries also cost their list and index nodes; a rough constant is enough
+// for budgeting.
+const size_t kEntryOverhead = 96;
+
+uint64_t Mix(uint64_t value) {
+  value ^= value >> 33;
+  value *= 0xff51afd7ed558ccdull;
+  value ^= value >> 33;
+  value *= 0xc4ceb9fe1a85ec53ull;
+  value ^= value >> 33;
+  return value;
+}
+
+size_t GetEntryBytes(const ChunkMeshData& mesh) {
+  return mesh.GetByteSize() + kEntryOverhead;
+}
+}  // namespace
+
+ChunkMeshCache::ChunkMeshCache(size_t max_bytes)
+    : max_bytes_(max_bytes), bytes_(0) {
+}
+
+ChunkMeshKey ChunkMeshCache::MakeKey(const BlockId* voxels, size_t count,
+                                     MesherMode mode, int lod) {
+  // Four block IDs per word, each word mixed before it is folded in, so
+  // the hash depends on every voxel and on where it is.
+  const size_t kPerWord = sizeof(uint64_t) / sizeof(BlockId);
+  uint64_t hash = Mix(count);
+  size_t i = 0;
+  for (; i + kPerWord <= count; i += kPerWord) {
+    uint64_t word;
+    std::memcpy(&word, voxels + i, sizeof(word));
+    hash = (hash ^ Mix(word + i)) * 0x9e3779b97f4a7c15ull;
+  }
+  for (; i < count; i++)
+    hash = (hash ^ Mix(voxels[i] + i)) * 0x9e3779b97f4a7c15ull;
+
+  ChunkMeshKey key;
+  key.hash = Mix(hash);
+  key.mode = mode;
+  key.lod = lod;
+  return key;
+}
+
+bool ChunkMeshCache::Find(const ChunkMeshKey& key, ChunkMeshData& mesh) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+      entries_.splice(entries_.begin(), entries_, it->second);
+      mesh = it->second->mesh;
+      stats_.hits++;
+      return true;
+    }
+    if (disk_directory_.empty()) {
+      stats_.misses++;
+      return false;
+    }
+    path = GetFilePath(key);
+  }
+
+  // Disk reads happen outside the lock so other workers keep going.
+  bool found = ReadFile(path, mesh);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!found) {
+    stats_.misses++;
+    return false;
+  }
+  stats_.hits++;
+  stats_.disk_hits++;
+  if (index_.count(key) == 0)
+    InsertInMemory(key, mesh);
+  return true;
+}
+
+void ChunkMeshCache::Insert(const ChunkMeshKey& key,
+                            const ChunkMeshData& mesh) {
+  std::string path;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(key) != 0)
+      return;
+    InsertInMemory(key, mesh);
+    if (!disk_directory_.empty())
+      path = GetFilePath(key);
+  }
+  if (!path.empty())
+    WriteFile(path, mesh);
+}
+
+void ChunkMeshCache::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  index_.clear();
+  bytes_ = 0;
+}
+
+void ChunkMeshCache::SetMaxBytes(size_t max_bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_bytes_ = max_bytes;
+  EvictToBudget();
+}
+
+void ChunkMeshCache::SetDiskDirectory(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  disk_directory_ = directory;
+}
+
+ChunkMeshCacheStats ChunkMeshCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ChunkMeshCacheStats stats = stats_;
+  stats.entries = entries_.size();
+  stats.bytes = bytes_;
+  return stats;
+}
+
+void ChunkMeshCache::InsertInMemory(const ChunkMeshKey& key,
+                                    ChunkMeshData mesh) {
+  size_t size = GetEntryBytes(mesh);
+  // A mesh larger than the whole budget would only evict everything else.
+  if (size > max_bytes_)
+    return;
+  entries_.push_front({key, std::move(mesh)});
+  index_[key] = entries_.begin();
+  bytes_ += size;
+  EvictToBudget();
+}
+
+void ChunkMeshCache::EvictToBudget() {
+  while (bytes_ > max_bytes_ && !entries_.empty()) {
+    const Entry& oldest = entries_.back();
+    bytes_ -= GetEntryBytes(oldest.mesh);
+    index_.erase(oldest.key);
+    entries_.pop_back();
+  }
+}
+
+std::string ChunkMeshCache::GetFilePath(const ChunkMeshKey& key) const {
+  char name[64];
+  std::snprintf(name, sizeof(name), "%016llx-%d-%d.mesh",
+                static_cast<unsigned long long>(key.hash),
+                static_cast<int>(key.mode), key.lod);
+  return disk_directory_ + "/" + name;
+}
+
+bool ChunkMeshCache::ReadFile(const std::string& path, ChunkMeshData& mesh) {
+  std::ifstream ifs(path, std::ios::binary);
+  if (!ifs)
+    return false;
+  uint32_t header[3];
+  if (!ifs.read(reinterpret_cast<char*>(header), sizeof(header)) ||
+      header[0] != kFileMagic || header[1] != kFileVersion ||
+      header[2] % 4 != 0 || header[2] > kMaxFileVertices)
+    return false;
+  std::vector<uint32_t> vertices(header[2]);
+  if (!ifs.read(reinterpret_cast<char*>(vertices.data()),
+                vertices.size() * sizeof(uint32_t)))
+    return false;
+  mesh.vertices = std::move(vertices);
+  return true;
+}
+
+void ChunkMeshCache::WriteFile(const std::string& path,
+                               const ChunkMeshData& mesh) {
+  // Workers meshing identical chunks may write the same file at once, so
+  // each writes its own temporary file and renames it into place.
+  static std::atomic<uint64_t> next_temp(0);
+  std::ostringstream temp_path;
+  temp_path << path << ".tmp" << next_temp++;
+  {
+    std::ofstream ofs(temp_path.str(), std::ios::binary);
+    if (!ofs)
+      return;
+    uint32_t header[3] = {kFileMagic, kFileVersion,
+                          static_cast<uint32_t>(mesh.vertices.size())};
+    ofs.write(reinterpret_cast<const char*>(header), sizeof(header));
+    ofs.write(reinterpret_cast<const char*>(mesh.vertices.data()),
+              mesh.GetByteSize());
+    if (!ofs) {
+      ofs.close();
+      std::remove(temp_path.str().c_str());
+      return;
+    }
+  }
+  // The disk cache is best effort: a failed write is just a future miss.
+  if (std::rename(temp_path.str().c_str(), path.c_str()) != 0)
+    std::remove(temp_path.str().c_str());
+}
+}  // namespace GLOO
@@ -0,0 +1,102 @@
+#ifndef CHUNK_MESH_CACHE_H_
+#define CHUNK_MESH_CACHE_H_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "ChunkMesher.hpp"
+
+namespace GLOO {
+// Identifies a mesh by what it is built from: a hash of the padded voxels
+// the mesher reads (the chunk plus its border, see PaddedChunkVoxels and
+// LodChunkVoxels), the mesher mode and the level of detail. Meshes are in
+// chunk-local coordinates, so chunks anywhere with the same content share
+// one entry.
+struct ChunkMeshKey {
+  uint64_t hash;
+  MesherMode mode;
+  int lod;
+
+  bool operator==(const ChunkMeshKey& other) const {
+    return hash == other.hash && mode == other.mode && lod == other.lod;
+  }
+};
+
+struct ChunkMeshKeyHash {
+  size_t operator()(const ChunkMeshKey& key) const {
+    uint64_t variant = static_cast<uint64_t>(key.mode) << 56 |
+                       static_cast<uint64_t>(key.lod) << 60;
+    return static_cast<size_t>(key.hash ^ variant);
+  }
+};
+
+struct ChunkMeshCacheStats {
+  size_t hits = 0;
+  // Hits found on disk rather than in memory; included in hits.
+  size_t disk_hits = 0;
+  size_t misses = 0;
+  size_t entries = 0;
+  size_t bytes = 0;
+};
+
+// Finished chunk meshes by content, so a chunk whose voxels and border come
+// back unchanged (revisited terrain, reverted edits, repeated flat or built
+// chunks) reuses its mesh instead of being meshed again. Memory holds the
+// most recently used meshes up to a byte budget. With a disk directory set,
+// every mesh is also written there and misses in memory fall back to it,
+// so the cache survives restarts; the directory must exist and is never
+// pruned.
+//
+// Keys are 64-bit hashes, so two different neighbourhoods could in theory
+// share a mesh; with well-mixed hashes the odds are negligible next to the
+// number of chunks a session meshes. Thread-safe: workers look meshes up
+// and insert them concurrently.
+class ChunkMeshCache {
+ public:
+  explicit ChunkMeshCache(size_t max_bytes = 32 * 1024 * 1024);
+
+  static ChunkMeshKey MakeKey(const BlockId* voxels, size_t count,
+                              MesherMode mode, int lod);
+
+  // Copies the cached mesh into mesh and returns true on a hit.
+  bool Find(const ChunkMeshKey& key, ChunkMeshData& mesh);
+  void Insert(const ChunkMeshKey& key, const ChunkMeshData& mesh);
+  // Drops the meshes held in memory; files on disk stay.
+  void Clear();
+
+  void SetMaxBytes(size_t max_bytes);
+  // An empty directory turns the disk cache off.
+  void SetDiskDirectory(const std::string& directory);
+  ChunkMeshCacheStats GetStats() const;
+
+ private:
+  struct Entry {
+    ChunkMeshKey key;
+    ChunkMeshData mesh;
+  };
+  using EntryList = std::list<Entry>;
+
+  // Both expect mutex_ to be held.
+  void InsertInMemory(const ChunkMeshKey& key, ChunkMeshData mesh);
+  void EvictToBudget();
+
+  std::string GetFilePath(const ChunkMeshKey& key) const;
+  static bool ReadFile(const std::string& path, ChunkMeshData& mesh);
+  static void WriteFile(const std::string& path, const ChunkMeshData& mesh);
+
+  mutable std::mutex mutex_;
+  // Most recently used first.
+  EntryList entries_;
+  std::unordered_map<ChunkMeshKey, EntryList::iterator, ChunkMeshKeyHash>
+      index_;
+  size_t max_bytes_;
+  size_t bytes_;
+  std::string disk_directory_;
+  ChunkMeshCacheStats stats_;
+};
+}  // namespace GLOO
+
+#endif
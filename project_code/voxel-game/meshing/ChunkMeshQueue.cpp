@@ -0,0 +1,63 @@
+#include "ChunkMeshQueue.hpp"
+
+namespace GLOO {
+ChunkMeshQueue::ChunkMeshQueue(ThreadPool& pool, ChunkMeshCache* cache)
+    : pool_(pool), cache_(cache), completed_(std::make_shared<Completed>()),
+      next_ticket_(0) {
+}
+
+void ChunkMeshQueue::Request(const ChunkCoord& coord,
+                             ChunkNeighborhood neighborhood,
+                             MesherMode mode, int lod) {
+  uint64_t ticket = next_ticket_++;
+  latest_tickets_[coord] = ticket;
+
+  std::shared_ptr<Completed> completed = completed_;
+  ChunkMeshCache* cache = cache_;
+  // std::function needs a copyable callable, so the snapshot travels in a
+  // shared_ptr rather than being moved into the lambda.
+  auto snapshot =
+      std::make_shared<ChunkNeighborhood>(std::move(neighborhood));
+  pool_.Submit([completed, cache, snapshot, coord, ticket, mode, lod]() {
+    Finished finished;
+    finished.coord = coord;
+    finished.ticket = ticket;
+    finished.mesh = ChunkMesher::Mesh(*snapshot, mode, lod, cache);
+    std::lock_guard<std::mutex> lock(completed->mutex);
+    completed->meshes.push_back(std::move(finished));
+  });
+}
+
+void ChunkMeshQueue::Cancel(const ChunkCoord& coord) {
+  latest_tickets_.erase(coord);
+}
+
+void ChunkMeshQueue::CancelAll() {
+  latest_tickets_.clear();
+}
+
+std::vector<ChunkMeshResult> ChunkMeshQueue::TakeResults(
+    const ChunkUploadBudget& budget) {
+  std::vector<ChunkMeshResult> results;
+  size_t bytes = 0;
+  std::lock_guard<std::mutex> lock(completed_->mutex);
+  auto& meshes = completed_->meshes;
+  while (!meshes.empty() && results.size() < budget.max_chunks) {
+    Finished& finished = meshes.front();
+    auto latest = latest_tickets_.find(finished.coord);
+    if (latest == latest_tickets_.end() ||
+        latest->second != finished.ticket) {
+      meshes.pop_front();
+      continue;
+    }
+    size_t size = finished.mesh.GetByteSize();
+    if (!results.empty() && bytes + size > budget.max_bytes)
+      break;
+    bytes += size;
+    latest_tickets_.erase(latest);
+    results.push_back({finished.coord, std::move(finished.mesh)});
+    meshes.pop_front();
+  }
+  return results;
+}
+}  // namespace GLOO
@@ -0,0 +1,81 @@
+#ifndef CHUNK_MESH_QUEUE_H_
+#define CHUNK_MESH_QUEUE_H_
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "ThreadPool.hpp"
+
+#include "ChunkMeshCache.hpp"
+#include "ChunkMesher.hpp"
+
+namespace GLOO {
+// How much finished meshing work the render thread takes per frame.
+// At least one mesh is always handed out, however large.
+struct ChunkUploadBudget {
+  size_t max_bytes = 4 * 1024 * 1024;
+  size_t max_chunks = 16;
+};
+
+struct ChunkMeshResult {
+  ChunkCoord coord;
+  ChunkMeshData mesh;
+};
+
+// Meshes chunks on a thread pool. The caller snapshots a chunk's
+// neighbourhood on the owning thread and requests a mesh; finished meshes
+// queue up until TakeResults hands them out, oldest first, within an upload
+// budget.
+//
+// Only the latest request for a chunk counts: re-requesting or cancelling
+// a chunk makes the meshes of earlier requests stale, and they are dropped
+// rather than returned. Requests, cancellation and TakeResults must come
+// from one thread; only the meshing itself runs on the workers.
+class ChunkMeshQueue {
+ public:
+  // Workers look meshes up in the cache, if there is one, and add the ones
+  // they build; it must outlive the pool's running jobs.
+  explicit ChunkMeshQueue(ThreadPool& pool, ChunkMeshCache* cache = nullptr);
+
+  void Request(const ChunkCoord& coord, ChunkNeighborhood neighborhood,
+               MesherMode mode, int lod = 0);
+  void Cancel(const ChunkCoord& coord);
+  // Forgets every request; meshes in flight are dropped when they finish.
+  void CancelAll();
+
+  std::vector<ChunkMeshResult> TakeResults(const ChunkUploadBudget& budget);
+
+  // Chunks with a live request that TakeResults has not returned yet.
+  size_t GetPendingCount() const {
+    return latest_tickets_.size();
+  }
+  bool IsPending(const ChunkCoord& coord) const {
+    return latest_tickets_.count(coord) != 0;
+  }
+
+ private:
+  struct Finished {
+    ChunkCoord coord;
+    uint64_t ticket;
+    ChunkMeshData mesh;
+  };
+  // Written by the workers. Held through a shared_ptr so jobs still running
+  // when the queue goes away have somewhere to put their mesh.
+  struct Completed {
+    std::mutex mutex;
+    std::deque<Finished> meshes;
+  };
+
+  ThreadPool& pool_;
+  ChunkMeshCache* cache_;
+  std::shared_ptr<Completed> completed_;
+  // Ticket of the live request per chunk; tickets only ever grow.
+  std::unordered_map<ChunkCoord, uint64_t, ChunkCoordHash> latest_tickets_;
+  uint64_t next_ticket_;
+};
+}  // namespace GLOO
+
+#endif
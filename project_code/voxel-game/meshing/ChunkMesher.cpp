@@ -0,0 +1,447 @@
+#include "ChunkMesher.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+#include "BinaryChunkMesher.hpp"
+#include "ChunkMeshCache.hpp"
+
+namespace GLOO {
+namespace {
+const FaceAxes kFaceAxes[kBlockFaceCount] = {
+    {0, 1, 2, 1},   // PosX: y x z = +x
+    {0, 2, 1, -1},  // NegX: z x y = -x
+    {1, 2, 0, 1},   // PosY: z x x = +y
+    {1, 0, 2, -1},  // NegY: x x z = -y
+    {2, 0, 1, 1},   // PosZ: x x y = +z
+    {2, 1, 0, -1},  // NegZ: y x x = -z
+};
+
+// Offset of the neighbour across each face in PaddedChunkVoxels indices.
+const int kPaddedNeighborOffsets[kBlockFaceCount] = {
+    1,
+    -1,
+    PaddedChunkVoxels::kSize,
+    -PaddedChunkVoxels::kSize,
+    PaddedChunkVoxels::kSize* PaddedChunkVoxels::kSize,
+    -PaddedChunkVoxels::kSize * PaddedChunkVoxels::kSize,
+};
+// Index strides of the padded voxel array along x, y and z.
+const int kPaddedStrides[3] = {
+    1, PaddedChunkVoxels::kSize,
+    PaddedChunkVoxels::kSize * PaddedChunkVoxels::kSize};
+
+bool IsUniformOpaque(const VoxelStorage* storage) {
+  return storage != nullptr && storage->IsUniform() &&
+         BlockRegistry::GetInstance().IsOpaque(
+             static_cast<BlockId>(storage->GetUniformType()));
+}
+
+// Block of a coarse cell inside the chunk: the topmost opaque block, or
+// failing that the topmost block of any kind. min is the cell's first
+// voxel.
+BlockId DownsampleInteriorCell(const PaddedChunkVoxels& voxels,
+                               const uint8_t* opaque, const glm::ivec3& min,
+                               int scale) {
+  BlockId top = 0;
+  for (int y = min.y + scale - 1; y >= min.y; y--) {
+    for (int z = min.z; z < min.z + scale; z++) {
+      for (int x = min.x; x < min.x + scale; x++) {
+        BlockId block = voxels.Get(x, y, z);
+        if (opaque[block])
+          return block;
+        if (top == 0)
+          top = block;
+      }
+    }
+  }
+  return top;
+}
+
+// Block of a coarse border cell, read from the neighbours: the topmost
+// block if every voxel is opaque, the block if they are all the same, and
+// air otherwise.
+BlockId DownsampleBorderCell(const ChunkNeighborhood& neighborhood,
+                             const uint8_t* opaque, const glm::ivec3& min,
+                             int scale) {
+  BlockId top = static_cast<BlockId>(
+      neighborhood.Get(min.x, min.y + scale - 1, min.z));
+  bool all_opaque = opaque[top] != 0;
+  bool uniform = true;
+  for (int y = min.y + scale - 1; y >= min.y; y--) {
+    for (int z = min.z; z < min.z + scale; z++) {
+      for (int x = min.x; x < min.x + scale; x++) {
+        BlockId block = static_cast<BlockId>(neighborhood.Get(x, y, z));
+        all_opaque &= opaque[block] != 0;
+        uniform &= block == top;
+        if (!all_opaque && !uniform)
+          return 0;
+      }
+    }
+  }
+  return top;
+}
+
+// The scalar greedy sweep over a padded grid of kSize^3 cells, shared by
+// full-resolution chunks and the coarse levels of detail.
+template <int kSize>
+void CollectGreedyQuadsIn(const BlockId* data,
+                          std::vector<ChunkQuad>& quads) {
+  const int kPadded = kSize + 2;
+  const int strides[3] = {1, kPadded, kPadded * kPadded};
+  const uint8_t* opaque = BlockRegistry::GetInstance().GetOpaqueTable();
+  // Block and AO of the visible face at (u, v) of the current slice, as
+  // block | ao << 16, or 0 where no face shows.
+  uint32_t mask[kSize * kSize];
+
+  for (int f = 0; f < kBlockFaceCount; f++) {
+    FaceAxes axes = GetFaceAxes(static_cast<BlockFace>(f));
+    int neighbor_offset = axes.sign * strides[axes.axis];
+    int stride_u = strides[axes.u];
+    int stride_v = strides[axes.v];
+    for (int d = 0; d < kSize; d++) {
+      int slice =
+          strides[0] + strides[1] + strides[2] + d * strides[axes.axis];
+      bool any_visible = false;
+      for (int v = 0; v < kSize; v++) {
+        int index = slice + v * stride_v;
+        uint32_t* mask_row = mask + v * kSize;
+        for (int u = 0; u < kSize; u++, index += stride_u) {
+          BlockId block = data[index];
+          int front = index + neighbor_offset;
+          BlockId neighbor = data[front];
+          bool visible = block != static_cast<BlockId>(VoxelType::Air) &&
+                         !opaque[neighbor] && neighbor != block;
+          mask_row[u] =
+              visible ? block | static_cast<uint32_t>(ComputeFaceAo(
+                                    data, opaque, front, stride_u, stride_v))
+                                    << 16
+                      : 0;
+          any_visible |= visible;
+        }
+      }
+      if (!any_visible)
+        continue;
+
+      for (int v = 0; v < kSize; v++) {
+        for (int u = 0; u < kSize;) {
+          uint32_t key = mask[u + v * kSize];
+          if (key == 0) {
+            u++;
+            continue;
+          }
+          uint8_t ao = static_cast<uint8_t>(key >> 16);
+          int width = 1;
+          if (IsAoConstantAlongU(ao)) {
+            while (u + width < kSize &&
+                   mask[u + width + v * kSize] == key)
+              width++;
+          }
+          int height = 1;
+          if (IsAoConstantAlongV(ao)) {
+            for (; v + height < kSize; height++) {
+              const uint32_t* row = mask + u + (v + height) * kSize;
+              int i = 0;
+              while (i < width && row[i] == key)
+                i++;
+              if (i < width)
+                break;
+            }
+          }
+          for (int j = 0; j < height; j++) {
+            uint32_t* row = mask + u + (v + j) * kSize;
+            std::fill(row, row + width, 0u);
+          }
+
+          glm::ivec3 corner;
+          corner[axes.axis] = d;
+          corner[axes.u] = u;
+          corner[axes.v] = v;
+          ChunkQuad quad;
+          quad.x = static_cast<uint8_t>(corner.x);
+          quad.y = static_cast<uint8_t>(corner.y);
+          quad.z = static_cast<uint8_t>(corner.z);
+          quad.width = static_cast<uint8_t>(width);
+          quad.height = static_cast<uint8_t>(height);
+          quad.face = static_cast<BlockFace>(f);
+          quad.block = static_cast<BlockId>(key & 0xFFFF);
+          quad.ao = ao;
+          quads.push_back(quad);
+          u += width;
+        }
+      }
+    }
+  }
+}
+}  // namespace
+
+FaceAxes GetFaceAxes(BlockFace face) {
+  return kFaceAxes[static_cast<int>(face)];
+}
+
+glm::ivec3 GetFaceNormal(BlockFace face) {
+  FaceAxes axes = GetFaceAxes(face);
+  glm::ivec3 normal(0);
+  normal[axes.axis] = axes.sign;
+  return normal;
+}
+
+PaddedChunkVoxels::PaddedChunkVoxels(const ChunkNeighborhood& neighborhood)
+    : voxels_(kVolume, 0) {
+  const VoxelStorage* center = neighborhood.GetCenterChunk();
+  if (center != nullptr) {
+    if (center->IsUniform()) {
+      BlockId id = static_cast<BlockId>(center->GetUniformType());
+      for (int z = 0; z < kChunkSize; z++)
+        for (int y = 0; y < kChunkSize; y++)
+          for (int x = 0; x < kChunkSize; x++)
+            voxels_[Index(x, y, z)] = id;
+    } else if (std::is_same<ChunkLayout,
+                            LinearChunkLayout<kChunkSizeLog2>>::value) {
+      // Rows are contiguous in storage, so decode them a word at a time.
+      VoxelType row[kChunkSize];
+      for (int z = 0; z < kChunkSize; z++) {
+        for (int y = 0; y < kChunkSize; y++) {
+          center->GetRange(Chunk::Index(0, y, z), kChunkSize, row);
+          BlockId* out = &voxels_[Index(0, y, z)];
+          for (int x = 0; x < kChunkSize; x++)
+            out[x] = static_cast<BlockId>(row[x]);
+        }
+      }
+    } else {
+      for (int z = 0; z < kChunkSize; z++)
+        for (int y = 0; y < kChunkSize; y++)
+          for (int x = 0; x < kChunkSize; x++)
+            voxels_[Index(x, y, z)] = static_cast<BlockId>(
+                center->Get(Chunk::Index(x, y, z)));
+    }
+  }
+
+  // One-voxel shell from the neighbours. Rows that cross the interior only
+  // need their two end voxels.
+  for (int z = -1; z <= kChunkSize; z++) {
+    for (int y = -1; y <= kChunkSize; y++) {
+      bool interior_row =
+          y >= 0 && y < kChunkSize && z >= 0 && z < kChunkSize;
+      for (int x = -1; x <= kChunkSize;
+           x += (interior_row && x == -1) ? kChunkSize + 1 : 1) {
+        voxels_[Index(x, y, z)] =
+            static_cast<BlockId>(neighborhood.Get(x, y, z));
+      }
+    }
+  }
+}
+
+LodChunkVoxels::LodChunkVoxels(const ChunkNeighborhood& neighborhood,
+                               int lod)
+    : lod_(lod) {
+  if (lod < 1 || lod >= kChunkLodCount)
+    throw std::runtime_error("Unsupported chunk level of detail " +
+                             std::to_string(lod));
+  int size = GetSize();
+  int scale = GetScale();
+  int padded = size + 2;
+  voxels_.assign(padded * padded * padded, 0);
+  const uint8_t* opaque = BlockRegistry::GetInstance().GetOpaqueTable();
+
+  const VoxelStorage* center = neighborhood.GetCenterChunk();
+  if (center != nullptr && center->IsUniform()) {
+    BlockId id = static_cast<BlockId>(center->GetUniformType());
+    for (int z = 0; z < size; z++)
+      for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+          voxels_[Index(x, y, z)] = id;
+  } else if (center != nullptr) {
+    PaddedChunkVoxels full(neighborhood);
+    for (int z = 0; z < size; z++)
+      for (int y = 0; y < size; y++)
+        for (int x = 0; x < size; x++)
+          voxels_[Index(x, y, z)] = DownsampleInteriorCell(
+              full, opaque, glm::ivec3(x, y, z) * scale, scale);
+  }
+
+  for (int z = -1; z <= size; z++) {
+    for (int y = -1; y <= size; y++) {
+      bool interior_row = y >= 0 && y < size && z >= 0 && z < size;
+      for (int x = -1; x <= size;
+           x += (interior_row && x == -1) ? size + 1 : 1) {
+        voxels_[Index(x, y, z)] = DownsampleBorderCell(
+            neighborhood, opaque, glm::ivec3(x, y, z) * scale, scale);
+      }
+    }
+  }
+}
+
+bool ChunkMesher::IsTriviallyEmpty(const ChunkNeighborhood& neighborhood) {
+  const VoxelStorage* center = neighborhood.GetCenterChunk();
+  if (center == nullptr)
+    return true;
+  if (center->IsUniform() && center->GetUniformType() == VoxelType::Air)
+    return true;
+  if (!IsUniformOpaque(center))
+    return false;
+  for (int f = 0; f < kBlockFaceCount; f++) {
+    if (!IsUniformOpaque(
+            neighborhood.GetChunk(GetFaceNormal(static_cast<BlockFace>(f)))))
+      return false;
+  }
+  return true;
+}
+
+void ChunkMesher::CollectQuads(const PaddedChunkVoxels& voxels,
+                               std::vector<ChunkQuad>& quads) {
+  const uint8_t* opaque = BlockRegistry::GetInstance().GetOpaqueTable();
+  const BlockId* data = voxels.GetData();
+  int strides_u[kBlockFaceCount], strides_v[kBlockFaceCount];
+  for (int f = 0; f < kBlockFaceCount; f++) {
+    FaceAxes axes = GetFaceAxes(static_cast<BlockFace>(f));
+    strides_u[f] = kPaddedStrides[axes.u];
+    strides_v[f] = kPaddedStrides[axes.v];
+  }
+  for (int z = 0; z < kChunkSize; z++) {
+    for (int y = 0; y < kChunkSize; y++) {
+      int index = PaddedChunkVoxels::Index(0, y, z);
+      for (int x = 0; x < kChunkSize; x++, index++) {
+        BlockId block = data[index];
+        if (block == static_cast<BlockId>(VoxelType::Air))
+          continue;
+        for (int f = 0; f < kBlockFaceCount; f++) {
+          int front = index + kPaddedNeighborOffsets[f];
+          BlockId neighbor = data[front];
+          if (opaque[neighbor] || neighbor == block)
+            continue;
+          ChunkQuad quad;
+          quad.x = static_cast<uint8_t>(x);
+          quad.y = static_cast<uint8_t>(y);
+          quad.z = static_cast<uint8_t>(z);
+          quad.width = 1;
+          quad.height = 1;
+          quad.face = static_cast<BlockFace>(f);
+          quad.block = block;
+          quad.ao = ComputeFaceAo(data, opaque, front, strides_u[f],
+                                  strides_v[f]);
+          quads.push_back(quad);
+        }
+      }
+    }
+  }
+}
+
+void ChunkMesher::CollectGreedyQuads(const PaddedChunkVoxels& voxels,
+                                     std::vector<ChunkQuad>& quads) {
+  CollectGreedyQuadsIn<kChunkSize>(voxels.GetData(), quads);
+}
+
+void ChunkMesher::CollectLodQuads(const LodChunkVoxels& voxels,
+                                  std::vector<ChunkQuad>& quads) {
+  size_t first = quads.size();
+  switch (voxels.GetLod()) {
+    case 1:
+      CollectGreedyQuadsIn<(kChunkSize >> 1)>(voxels.GetData(), quads);
+      break;
+    case 2:
+      CollectGreedyQuadsIn<(kChunkSize >> 2)>(voxels.GetData(), quads);
+      break;
+    case 3:
+      CollectGreedyQuadsIn<(kChunkSize >> 3)>(voxels.GetData(), quads);
+      break;
+    default:
+      throw std::runtime_error("Unsupported chunk level of detail " +
+                               std::to_string(voxels.GetLod()));
+  }
+  int scale = voxels.GetScale();
+  for (size_t i = first; i < quads.size(); i++) {
+    ChunkQuad& quad = quads[i];
+    glm::ivec3 corner(quad.x, quad.y, quad.z);
+    corner *= scale;
+    // A positive face belongs to the last voxel of its cell, so it still
+    // sits on the cell's far side once built.
+    FaceAxes axes = GetFaceAxes(quad.face);
+    if (axes.sign > 0)
+      corner[axes.axis] += scale - 1;
+    quad.x = static_cast<uint8_t>(corner.x);
+    quad.y = static_cast<uint8_t>(corner.y);
+    quad.z = static_cast<uint8_t>(corner.z);
+    quad.width = static_cast<uint8_t>(quad.width * scale);
+    quad.height = static_cast<uint8_t>(quad.height * scale);
+  }
+}
+
+ChunkMeshData ChunkMesher::BuildMesh(const std::vector<ChunkQuad>& quads) {
+  const BlockRegistry& registry = BlockRegistry::GetInstance();
+  ChunkMeshData mesh;
+  mesh.vertices.reserve(quads.size() * 4);
+  for (const ChunkQuad& quad : quads) {
+    FaceAxes axes = GetFaceAxes(quad.face);
+    glm::ivec3 base(quad.x, quad.y, quad.z);
+    // Positive faces sit on the far side of their voxel.
+    if (axes.sign > 0)
+      base[axes.axis] += 1;
+    glm::ivec3 du(0), dv(0);
+    du[axes.u] = quad.width;
+    dv[axes.v] = quad.height;
+    uint16_t layer = registry.GetFaceLayer(quad.block, quad.face);
+    const glm::ivec3 corners[4] = {base, base + du, base + du + dv,
+                                   base + dv};
+    int ao[4];
+    for (int i = 0; i < 4; i++)
+      ao[i] = GetCornerAo(quad.ao, i);
+    // Starting one corner later moves the split to the other diagonal.
+    // Either way the corners stay counter-clockwise seen from the normal
+    // side, since u x v = normal.
+    int start = ao[0] + ao[2] > ao[1] + ao[3] ? 1 : 0;
+    for (int i = 0; i < 4; i++) {
+      int corner = (start + i) & 3;
+      mesh.vertices.push_back(
+          PackChunkVertex(corners[corner], quad.face, ao[corner], layer));
+    }
+  }
+  return mesh;
+}
+
+ChunkMeshData ChunkMesher::Mesh(const ChunkNeighborhood& neighborhood,
+                                MesherMode mode, int lod,
+                                ChunkMeshCache* cache) {
+  if (IsTriviallyEmpty(neighborhood))
+    return ChunkMeshData();
+  ChunkMeshData mesh;
+  ChunkMeshKey key;
+  std::vector<ChunkQuad> quads;
+  if (lod > 0) {
+    LodChunkVoxels voxels(neighborhood, lod);
+    if (cache != nullptr) {
+      // Coarse meshes do not depend on the mode, so their keys leave it out.
+      key = ChunkMeshCache::MakeKey(voxels.GetData(), voxels.GetVolume(),
+                                    MesherMode::Greedy, lod);
+      if (cache->Find(key, mesh))
+        return mesh;
+    }
+    CollectLodQuads(voxels, quads);
+  } else {
+    PaddedChunkVoxels voxels(neighborhood);
+    if (cache != nullptr) {
+      key = ChunkMeshCache::MakeKey(voxels.GetData(),
+                                    PaddedChunkVoxels::kVolume, mode, 0);
+      if (cache->Find(key, mesh))
+        return mesh;
+    }
+    switch (mode) {
+      case MesherMode::Culled:
+        CollectQuads(voxels, quads);
+        break;
+      case MesherMode::Greedy:
+        CollectGreedyQuads(voxels, quads);
+        break;
+      case MesherMode::BinaryGreedy:
+        BinaryChunkMesher::CollectGreedyQuads(voxels, quads);
+        break;
+    }
+  }
+  mesh = BuildMesh(quads);
+  if (cache != nullptr)
+    cache->Insert(key, mesh);
+  return mesh;
+}
+}  // namespace GLOO
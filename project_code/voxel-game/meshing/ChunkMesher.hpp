@@ -0,0 +1,253 @@
+#ifndef CHUNK_MESHER_H_
+#define CHUNK_MESHER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "gloo/alias_types.hpp"
+
+#include "BlockRegistry.hpp"
+#include "storage/ChunkSnapshot.hpp"
+
+namespace GLOO {
+class ChunkMeshCache;
+
+enum class MesherMode {
+  // One quad per visible voxel face.
+  Culled,
+  // Visible faces merged into maximal rectangles of the same block type.
+  Greedy,
+  // Same quads as Greedy from the bitmask kernel (see BinaryChunkMesher).
+  BinaryGreedy,
+};
+
+// One rectangular voxel face. (x, y, z) is the voxel at the quad's min
+// corner; width and height count voxels along the face's u and v tangent
+// axes (see GetFaceAxes). ao holds the ambient occlusion level of the four
+// corners, 2 bits each, in vertex order: min corner, +u, +u+v, +v.
+struct ChunkQuad {
+  uint8_t x, y, z;
+  uint8_t width, height;
+  BlockFace face;
+  BlockId block;
+  uint8_t ao;
+};
+
+// Chunk mesh vertices are packed into 32 bits, decoded by VoxelShader:
+// 6 bits per axis of chunk-local position, 3 bits of face direction, 2 bits
+// of ambient occlusion (3 = unoccluded) and 9 bits of texture layer.
+const int kChunkVertexAoLevels = 4;
+const int kChunkVertexLayerBits = 9;
+static_assert(kChunkSize < 64, "Packed chunk vertices hold 6-bit positions");
+
+inline int GetCornerAo(uint8_t ao, int corner) {
+  return ao >> (2 * corner) & (kChunkVertexAoLevels - 1);
+}
+
+inline uint32_t PackChunkVertex(const glm::ivec3& position, BlockFace face,
+                                int ao_level, uint16_t layer) {
+  return static_cast<uint32_t>(position.x) |
+         static_cast<uint32_t>(position.y) << 6 |
+         static_cast<uint32_t>(position.z) << 12 |
+         static_cast<uint32_t>(face) << 18 |
+         static_cast<uint32_t>(ao_level) << 21 |
+         static_cast<uint32_t>(layer & ((1u << kChunkVertexLayerBits) - 1))
+             << 23;
+}
+
+// CPU-side mesh of one chunk, in chunk-local coordinates: four vertices
+// per quad, in the order a QuadIndexBuffer draws them, so no indices.
+struct ChunkMeshData {
+  std::vector<uint32_t> vertices;
+
+  bool IsEmpty() const {
+    return vertices.empty();
+  }
+  size_t GetQuadCount() const {
+    return vertices.size() / 4;
+  }
+  // Bytes this mesh takes to upload.
+  size_t GetByteSize() const {
+    return vertices.size() * sizeof(uint32_t);
+  }
+};
+
+// Axis layout of a face direction: the face is perpendicular to `axis`,
+// spans the `u` and `v` axes (with u x v pointing along the normal) and
+// faces the positive side of `axis` if `sign` is +1.
+struct FaceAxes {
+  int axis;
+  int u;
+  int v;
+  int sign;
+};
+FaceAxes GetFaceAxes(BlockFace face);
+glm::ivec3 GetFaceNormal(BlockFace face);
+
+// A chunk's block IDs plus a one-voxel border copied from its neighbours,
+// so meshing loops can test neighbours with flat array indexing and no
+// chunk-boundary special cases.
+class PaddedChunkVoxels {
+ public:
+  static const int kSize = kChunkSize + 2;
+  static const int kVolume = kSize * kSize * kSize;
+
+  explicit PaddedChunkVoxels(const ChunkNeighborhood& neighborhood);
+
+  // Local coordinates, each in [-1, kChunkSize].
+  BlockId Get(int x, int y, int z) const {
+    return voxels_[Index(x, y, z)];
+  }
+  static int Index(int x, int y, int z) {
+    return (x + 1) + kSize * ((y + 1) + kSize * (z + 1));
+  }
+  const BlockId* GetData() const {
+    return voxels_.data();
+  }
+
+ private:
+  std::vector<BlockId> voxels_;
+};
+
+// Levels of detail. Level 0 meshes voxels as they are; level L meshes the
+// chunk from cells of 2^L voxels per axis (see LodChunkVoxels), so each
+// level has roughly a quarter of the faces of the one before.
+const int kChunkLodCount = 4;
+static_assert((kChunkSize >> (kChunkLodCount - 1)) >= 2,
+              "Coarsest level of detail needs cells inside the chunk");
+
+// A chunk downsampled for a coarse level of detail, padded like
+// PaddedChunkVoxels with one cell of border from the neighbours.
+//
+// Downsampling is surface-preserving: a cell is opaque if any of its voxels
+// is, and otherwise takes any non-air block it holds, and its block is the
+// one nearest the top of the cell, so distant terrain keeps its grass and
+// never shrinks below the finer meshes. Border cells go the other way: they
+// are air unless every voxel in them is opaque or the same block. A coarse
+// mesh therefore closes itself off with skirt faces along the chunk border
+// wherever a neighbour at any finer level may be open, and chunks at
+// different levels meet without cracks and without knowing each other's
+// level.
+class LodChunkVoxels {
+ public:
+  // lod must be in [1, kChunkLodCount).
+  LodChunkVoxels(const ChunkNeighborhood& neighborhood, int lod);
+
+  int GetLod() const {
+    return lod_;
+  }
+  // Voxels per cell along each axis.
+  int GetScale() const {
+    return 1 << lod_;
+  }
+  // Cells per chunk along each axis.
+  int GetSize() const {
+    return kChunkSize >> lod_;
+  }
+
+  // Cell coordinates, each in [-1, GetSize()].
+  BlockId Get(int x, int y, int z) const {
+    return voxels_[Index(x, y, z)];
+  }
+  int Index(int x, int y, int z) const {
+    int padded = GetSize() + 2;
+    return (x + 1) + padded * ((y + 1) + padded * (z + 1));
+  }
+  const BlockId* GetData() const {
+    return voxels_.data();
+  }
+  size_t GetVolume() const {
+    return voxels_.size();
+  }
+
+ private:
+  int lod_;
+  std::vector<BlockId> voxels_;
+};
+
+// Classic voxel AO, from the cell in front of a face: each corner darkens
+// by one level per opaque block among its two edge neighbours and its
+// diagonal neighbour in that cell's plane, and two edge neighbours occlude
+// it fully whatever the diagonal. front is the cell's index into the
+// padded voxels, stride_u and stride_v the index strides of the face's
+// tangent axes. Returns the corner levels packed as in ChunkQuad::ao.
+inline int CornerAo(int side_a, int side_b, int diagonal) {
+  return side_a && side_b ? 0
+                          : kChunkVertexAoLevels - 1 -
+                                (side_a + side_b + diagonal);
+}
+
+inline uint8_t ComputeFaceAo(const BlockId* voxels, const uint8_t* opaque,
+                             int front, int stride_u, int stride_v) {
+  int u_lo = opaque[voxels[front - stride_u]] != 0;
+  int u_hi = opaque[voxels[front + stride_u]] != 0;
+  int v_lo = opaque[voxels[front - stride_v]] != 0;
+  int v_hi = opaque[voxels[front + stride_v]] != 0;
+  int lo_lo = opaque[voxels[front - stride_u - stride_v]] != 0;
+  int hi_lo = opaque[voxels[front + stride_u - stride_v]] != 0;
+  int hi_hi = opaque[voxels[front + stride_u + stride_v]] != 0;
+  int lo_hi = opaque[voxels[front - stride_u + stride_v]] != 0;
+  return static_cast<uint8_t>(CornerAo(u_lo, v_lo, lo_lo) |
+                              CornerAo(u_hi, v_lo, hi_lo) << 2 |
+                              CornerAo(u_hi, v_hi, hi_hi) << 4 |
+                              CornerAo(u_lo, v_hi, lo_hi) << 6);
+}
+
+// Greedy meshers only merge faces with the same AO, and only along an axis
+// the AO does not vary on, so a merged quad shades exactly like the faces
+// it replaces.
+inline bool IsAoConstantAlongU(uint8_t ao) {
+  return GetCornerAo(ao, 0) == GetCornerAo(ao, 1) &&
+         GetCornerAo(ao, 3) == GetCornerAo(ao, 2);
+}
+inline bool IsAoConstantAlongV(uint8_t ao) {
+  return GetCornerAo(ao, 0) == GetCornerAo(ao, 3) &&
+         GetCornerAo(ao, 1) == GetCornerAo(ao, 2);
+}
+
+// Builds chunk meshes from neighbourhood snapshots. Everything here is
+// GL-free and safe to run on worker threads once the block registry is set
+// up.
+class ChunkMesher {
+ public:
+  // Whether the chunk provably has no visible faces: it is missing or all
+  // air, or it is uniformly opaque and so are its six face neighbours.
+  static bool IsTriviallyEmpty(const ChunkNeighborhood& neighborhood);
+
+  // Hidden-face culling: one quad per voxel face between a block and a
+  // neighbour that does not hide it (a non-opaque block of another type),
+  // including across chunk borders. Every quad carries its corners' AO.
+  static void CollectQuads(const PaddedChunkVoxels& voxels,
+                           std::vector<ChunkQuad>& quads);
+
+  // Same faces as CollectQuads, but coplanar neighbouring faces of the same
+  // block and AO are merged into rectangles: each slice of each face
+  // direction is swept row by row, growing a quad along u first and then
+  // along v, as far as the AO allows (see IsAoConstantAlongU).
+  static void CollectGreedyQuads(const PaddedChunkVoxels& voxels,
+                                 std::vector<ChunkQuad>& quads);
+
+  // Greedy quads over the cells of a coarse level of detail, scaled back to
+  // voxel units, so they build into meshes like any other.
+  static void CollectLodQuads(const LodChunkVoxels& voxels,
+                              std::vector<ChunkQuad>& quads);
+
+  // Expands quads into packed vertices: four per quad, carrying the face
+  // direction, the corner's AO and the block's texture layer for that face.
+  // The shared quad indices split every quad along its first and third
+  // vertex; quads whose other diagonal is darker in sum rotate their
+  // vertices by one, so AO interpolates the same way whichever way the
+  // face is oriented.
+  static ChunkMeshData BuildMesh(const std::vector<ChunkQuad>& quads);
+
+  // Coarse levels of detail always merge greedily, whatever the mode. With
+  // a cache, the padded voxels are hashed once they are built and a cached
+  // mesh for them is returned instead of meshing again; new meshes are
+  // added to it.
+  static ChunkMeshData Mesh(const ChunkNeighborhood& neighborhood,
+                            MesherMode mode = MesherMode::BinaryGreedy,
+                            int lod = 0, ChunkMeshCache* cache = nullptr);
+};
+}  // namespace GLOO
+
+#endif
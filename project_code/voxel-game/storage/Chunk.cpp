@@ -0,0 +1,54 @@
+#include "Chunk.hpp"
+
+#include <atomic>
+
+namespace GLOO {
+namespace {
+std::shared_ptr<VoxelStorage> MakeStorage(const VoxelStorage& source) {
+  return std::allocate_shared<VoxelStorage>(
+      ChunkPayloadAllocator<VoxelStorage>(), source);
+}
+}  // namespace
+
+Chunk::Chunk(const ChunkCoord& coord)
+    : coord_(coord), storage_(MakeStorage(VoxelStorage(kChunkVolume))) {
+}
+
+VoxelStorage& Chunk::MutableStorage() {
+  if (storage_.use_count() > 1) {
+    storage_ = MakeStorage(*storage_);
+  } else {
+    // Snapshot holders only ever drop their references; pair with the
+    // release in that decrement so their reads finish before we write.
+    std::atomic_thread_fence(std::memory_order_acquire);
+  }
+  return *storage_;
+}
+
+bool Chunk::Set(int x, int y, int z, const Voxel& voxel) {
+  int index = Index(x, y, z);
+  // Rewriting a voxel with its current type must not force a copy.
+  if (storage_->Get(index) == voxel.getType())
+    return false;
+  MutableStorage().Set(index, voxel.getType());
+  dirty_.Include(glm::ivec3(x, y, z), glm::ivec3(x + 1, y + 1, z + 1));
+  return true;
+}
+
+void Chunk::Fill(const Voxel& voxel) {
+  if (IsUniform() && GetUniformVoxel().getType() == voxel.getType())
+    return;
+  dirty_.Include(glm::ivec3(0), glm::ivec3(kChunkSize));
+  if (storage_.use_count() > 1) {
+    storage_ = MakeStorage(VoxelStorage(kChunkVolume, voxel.getType()));
+  } else {
+    MutableStorage().Fill(voxel.getType());
+  }
+}
+
+void Chunk::Compact() {
+  if (storage_.use_count() > 1)
+    return;
+  MutableStorage().Compact();
+}
+}  // namespace GLOO
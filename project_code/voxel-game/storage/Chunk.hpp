@@ -0,0 +1,200 @@
+#ifndef CHUNK_H_
+#define CHUNK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "Voxel.hpp"
+#include "ChunkLayout.hpp"
+#include "VoxelStorage.hpp"
+
+namespace GLOO {
+// Chunks are cubes of kChunkSize^3 voxels. The size is a power of two so that
+// world <-> chunk conversions reduce to shifts and masks.
+const int kChunkSizeLog2 = 5;
+const int kChunkSize = 1 << kChunkSizeLog2;
+const int kChunkMask = kChunkSize - 1;
+const int kChunkVolume = kChunkSize * kChunkSize * kChunkSize;
+
+// Order of voxels inside a chunk's storage, picked at compile time with
+// VOXEL_CHUNK_MORTON_LAYOUT. Linear order is the default and the faster
+// one (see MortonChunkLayout). Code outside the storage should go through
+// Chunk::Index() and not assume either order.
+#if defined(VOXEL_CHUNK_MORTON_LAYOUT)
+using ChunkLayout = MortonChunkLayout<kChunkSizeLog2>;
+#else
+using ChunkLayout = LinearChunkLayout<kChunkSizeLog2>;
+#endif
+
+// Chunk coordinates index the grid of chunks, i.e. chunk (1, 0, 0) covers
+// world voxels [32, 64) x [0, 32) x [0, 32).
+using ChunkCoord = glm::ivec3;
+
+struct ChunkCoordHash {
+  std::size_t operator()(const ChunkCoord& c) const {
+    // Large primes from Teschner et al., "Optimized Spatial Hashing for
+    // Collision Detection of Deformable Objects". Multiplied as unsigned so
+    // far-away coordinates wrap instead of overflowing.
+    return static_cast<std::size_t>(static_cast<uint32_t>(c.x) * 73856093u ^
+                                    static_cast<uint32_t>(c.y) * 19349663u ^
+                                    static_cast<uint32_t>(c.z) * 83492791u);
+  }
+};
+
+// Arithmetic shifts floor towards negative infinity, which is what we want
+// for negative world coordinates.
+inline ChunkCoord WorldToChunkCoord(const glm::ivec3& world_pos) {
+  return ChunkCoord(world_pos.x >> kChunkSizeLog2,
+                    world_pos.y >> kChunkSizeLog2,
+                    world_pos.z >> kChunkSizeLog2);
+}
+
+inline glm::ivec3 WorldToLocal(const glm::ivec3& world_pos) {
+  return glm::ivec3(world_pos.x & kChunkMask, world_pos.y & kChunkMask,
+                    world_pos.z & kChunkMask);
+}
+
+inline glm::ivec3 ChunkOrigin(const ChunkCoord& coord) {
+  return coord * kChunkSize;
+}
+
+// Half-open box [min, max) of local voxel coordinates that changed since
+// the last time the chunk's edits were consumed.
+struct ChunkDirtyRegion {
+  glm::ivec3 min{kChunkSize};
+  glm::ivec3 max{0};
+
+  bool IsEmpty() const {
+    return min.x >= max.x || min.y >= max.y || min.z >= max.z;
+  }
+  void Include(const glm::ivec3& lo, const glm::ivec3& hi) {
+    min = glm::min(min, lo);
+    max = glm::max(max, hi);
+  }
+  // Whether the box reaches into the outermost depth voxel layers on the
+  // given side, i.e. whether a neighbour across that face that reads that
+  // many layers may see a change.
+  bool TouchesBorder(int axis, bool positive, int depth = 1) const {
+    return positive ? max[axis] > kChunkSize - depth : min[axis] < depth;
+  }
+};
+
+// A chunk's voxels live in a reference-counted VoxelStorage that is shared
+// with any outstanding snapshots and copied on write. Readers on other
+// threads take a snapshot and read it without locks, while the owning thread
+// keeps editing: the first edit after a snapshot clones the payload, so only
+// chunks that are actually touched get copied.
+//
+// Snapshots must be taken on the thread that edits the chunk (normally the
+// main thread) and can then be handed to any other thread.
+class Chunk {
+ public:
+  explicit Chunk(const ChunkCoord& coord);
+
+  Chunk(const Chunk&) = delete;
+  Chunk& operator=(const Chunk&) = delete;
+
+  const ChunkCoord& GetCoord() const {
+    return coord_;
+  }
+
+  glm::ivec3 GetOrigin() const {
+    return ChunkOrigin(coord_);
+  }
+
+  // Local coordinates must lie in [0, kChunkSize).
+  Voxel Get(int x, int y, int z) const {
+    return Voxel(storage_->Get(Index(x, y, z)));
+  }
+  // Returns whether the voxel changed.
+  bool Set(int x, int y, int z, const Voxel& voxel);
+
+  void Fill(const Voxel& voxel);
+
+  // Applies fn(x, y, z, current) -> VoxelType to every voxel in the local
+  // box [min, max) and returns how many voxels changed. The storage is
+  // cloned at most once, and the dirty region grows by the bounding box of
+  // the changes only.
+  template <typename Fn>
+  int EditRegion(const glm::ivec3& min, const glm::ivec3& max, Fn fn);
+
+  const ChunkDirtyRegion& GetDirtyRegion() const {
+    return dirty_;
+  }
+  bool IsDirty() const {
+    return !dirty_.IsEmpty();
+  }
+  void ClearDirty() {
+    dirty_ = ChunkDirtyRegion();
+  }
+
+  // Shrinks the palette after voxels have been overwritten, and drops the
+  // payload entirely if the chunk turned out to be uniform. Skipped while
+  // snapshots are outstanding, since it would force a copy.
+  void Compact();
+
+  // Uniform chunks (e.g. all air, all stone) own no voxel payload. Passes
+  // that visit every voxel should check this first.
+  bool IsUniform() const {
+    return storage_->IsUniform();
+  }
+  Voxel GetUniformVoxel() const {
+    return Voxel(storage_->GetUniformType());
+  }
+
+  const VoxelStorage& GetStorage() const {
+    return *storage_;
+  }
+
+  // Immutable view of the current voxels. Later edits to the chunk do not
+  // show up in it.
+  std::shared_ptr<const VoxelStorage> Snapshot() const {
+    return storage_;
+  }
+
+  static int Index(int x, int y, int z) {
+    return static_cast<int>(ChunkLayout::Index(x, y, z));
+  }
+
+ private:
+  // Returns storage that is safe to modify, cloning it if a snapshot still
+  // refers to the current one.
+  VoxelStorage& MutableStorage();
+
+  ChunkCoord coord_;
+  std::shared_ptr<VoxelStorage> storage_;
+  ChunkDirtyRegion dirty_;
+};
+
+template <typename Fn>
+int Chunk::EditRegion(const glm::ivec3& min, const glm::ivec3& max, Fn fn) {
+  VoxelStorage* storage = nullptr;
+  glm::ivec3 lo(kChunkSize), hi(0);
+  int changed = 0;
+  for (int z = min.z; z < max.z; z++) {
+    for (int y = min.y; y < max.y; y++) {
+      for (int x = min.x; x < max.x; x++) {
+        int index = Index(x, y, z);
+        VoxelType current = storage_->Get(index);
+        VoxelType next = fn(x, y, z, current);
+        if (next == current)
+          continue;
+        if (storage == nullptr)
+          storage = &MutableStorage();
+        storage->Set(index, next);
+        lo = glm::min(lo, glm::ivec3(x, y, z));
+        hi = glm::max(hi, glm::ivec3(x + 1, y + 1, z + 1));
+        changed++;
+      }
+    }
+  }
+  if (changed > 0)
+    dirty_.Include(lo, hi);
+  return changed;
+}
+}  // namespace GLOO
+
+#endif
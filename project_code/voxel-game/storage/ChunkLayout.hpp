@@ -0,0 +1,90 @@
+#ifndef CHUNK_LAYOUT_H_
+#define CHUNK_LAYOUT_H_
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace GLOO {
+// Maps local voxel coordinates inside a chunk to storage indices. Both
+// layouts take the chunk edge length as log2 so they can be benchmarked
+// against each other independently of kChunkSize.
+
+// x-major order: x is contiguous, then y, then z.
+template <int kSizeLog2>
+struct LinearChunkLayout {
+  static uint32_t Index(int x, int y, int z) {
+    return static_cast<uint32_t>(x | (y << kSizeLog2) | (z << (2 * kSizeLog2)));
+  }
+  static glm::ivec3 Decode(uint32_t index) {
+    const uint32_t mask = (1u << kSizeLog2) - 1;
+    return glm::ivec3(index & mask, (index >> kSizeLog2) & mask,
+                      index >> (2 * kSizeLog2));
+  }
+};
+
+// Spreads the low 10 bits of v so that bit i moves to bit 3 * i.
+constexpr uint32_t SpreadBits3(uint32_t v, int bit = 0) {
+  return bit == 10 ? 0
+                   : (((v >> bit) & 1u) << (3 * bit)) | SpreadBits3(v, bit + 1);
+}
+
+#define GLOO_MORTON_ROW(i)                                              \
+  SpreadBits3(i + 0), SpreadBits3(i + 1), SpreadBits3(i + 2),           \
+      SpreadBits3(i + 3), SpreadBits3(i + 4), SpreadBits3(i + 5),       \
+      SpreadBits3(i + 6), SpreadBits3(i + 7)
+// Lookup table for SpreadBits3 on one axis coordinate.
+constexpr uint32_t kMortonSpreadTable[64] = {
+    GLOO_MORTON_ROW(0),  GLOO_MORTON_ROW(8),  GLOO_MORTON_ROW(16),
+    GLOO_MORTON_ROW(24), GLOO_MORTON_ROW(32), GLOO_MORTON_ROW(40),
+    GLOO_MORTON_ROW(48), GLOO_MORTON_ROW(56)};
+#undef GLOO_MORTON_ROW
+
+// Inverse of SpreadBits3: gathers every third bit into the low 10 bits.
+inline uint32_t CompactBits3(uint32_t v) {
+  v &= 0x09249249u;
+  v = (v ^ (v >> 2)) & 0x030C30C3u;
+  v = (v ^ (v >> 4)) & 0x0300F00Fu;
+  v = (v ^ (v >> 8)) & 0x030000FFu;
+  v = (v ^ (v >> 16)) & 0x000003FFu;
+  return v;
+}
+
+// Z-order (Morton) layout: the bits of x, y and z are interleaved. Uses
+// PDEP/PEXT when compiled for BMI2, and a lookup table otherwise. Only an
+// alternative for experiments: a whole chunk fits in L2, and in
+// chunk-layout-benchmark Morton order is no faster than linear order at
+// meshing and slower at flood fill and raycasts, which pay for the
+// encoding on every step.
+template <int kSizeLog2>
+struct MortonChunkLayout {
+  static_assert(kSizeLog2 <= 6, "Morton lookup table covers 64 voxels per axis.");
+
+  static uint32_t Index(int x, int y, int z) {
+#if defined(__BMI2__)
+    return _pdep_u32(static_cast<uint32_t>(x), 0x09249249u) |
+           _pdep_u32(static_cast<uint32_t>(y), 0x12492492u) |
+           _pdep_u32(static_cast<uint32_t>(z), 0x24924924u);
+#else
+    return kMortonSpreadTable[x] | (kMortonSpreadTable[y] << 1) |
+           (kMortonSpreadTable[z] << 2);
+#endif
+  }
+  static glm::ivec3 Decode(uint32_t index) {
+#if defined(__BMI2__)
+    return glm::ivec3(_pext_u32(index, 0x09249249u),
+                      _pext_u32(index, 0x12492492u),
+                      _pext_u32(index, 0x24924924u));
+#else
+    return glm::ivec3(CompactBits3(index), CompactBits3(index >> 1),
+                      CompactBits3(index >> 2));
+#endif
+  }
+};
+}  // namespace GLOO
+
+#endif
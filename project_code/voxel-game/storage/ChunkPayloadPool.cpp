@@ -0,0 +1,181 @@
+#include "ChunkPayloadPool.hpp"
+
+#include <algorithm>
+
+namespace GLOO {
+namespace {
+// Slabs hold at least this many bytes, and at least kMinBlocksPerSlab blocks.
+const size_t kMinSlabSize = 64 * 1024;
+const size_t kMinBlocksPerSlab = 8;
+}  // namespace
+
+const size_t ChunkPayloadPool::kMinBlockSize;
+const size_t ChunkPayloadPool::kMaxBlockSize;
+
+ChunkPayloadPool::ChunkPayloadPool()
+    : memory_cap_(0), retained_empty_slabs_(1) {
+  for (size_t size = kMinBlockSize; size <= kMaxBlockSize; size <<= 1) {
+    SizeClass size_class;
+    size_class.block_size = size;
+    size_class.empty_slabs = 0;
+    classes_.push_back(size_class);
+  }
+}
+
+size_t ChunkPayloadPool::ClassIndex(size_t bytes) {
+  size_t index = 0;
+  size_t size = kMinBlockSize;
+  while (size < bytes) {
+    size <<= 1;
+    index++;
+  }
+  return index;
+}
+
+bool ChunkPayloadPool::CanReserve(size_t bytes) const {
+  return memory_cap_ == 0 || stats_.reserved_bytes + bytes <= memory_cap_;
+}
+
+ChunkPayloadPool::Slab* ChunkPayloadPool::CreateSlab(SizeClass& size_class) {
+  size_t block_count =
+      std::max(kMinBlocksPerSlab, kMinSlabSize / size_class.block_size);
+  size_t slab_bytes = block_count * size_class.block_size;
+  if (!CanReserve(slab_bytes))
+    throw std::bad_alloc();
+
+  std::unique_ptr<Slab> slab(new Slab());
+  slab->memory.reset(new char[slab_bytes]);
+  slab->block_size = size_class.block_size;
+  slab->block_count = block_count;
+  slab->live = 0;
+  slab->free_head = nullptr;
+  // Thread the free list back to front so blocks are handed out in address
+  // order.
+  for (size_t i = block_count; i-- > 0;) {
+    void* block = slab->memory.get() + i * size_class.block_size;
+    *static_cast<void**>(block) = slab->free_head;
+    slab->free_head = block;
+  }
+  slab->in_partial_list = true;
+
+  Slab* raw = slab.get();
+  slabs_[raw->memory.get()] = std::move(slab);
+  size_class.partial.push_back(raw);
+  size_class.empty_slabs++;
+
+  stats_.slabs++;
+  stats_.empty_slabs++;
+  stats_.free_blocks += block_count;
+  stats_.reserved_bytes += slab_bytes;
+  return raw;
+}
+
+void ChunkPayloadPool::ReleaseSlab(SizeClass& size_class, Slab* slab) {
+  size_class.partial.erase(std::find(size_class.partial.begin(),
+                                     size_class.partial.end(), slab));
+  size_class.empty_slabs--;
+  stats_.slabs--;
+  stats_.empty_slabs--;
+  stats_.free_blocks -= slab->block_count;
+  stats_.reserved_bytes -= slab->block_count * slab->block_size;
+  slabs_.erase(slab->memory.get());
+}
+
+void* ChunkPayloadPool::Allocate(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (bytes > kMaxBlockSize) {
+    if (!CanReserve(bytes))
+      throw std::bad_alloc();
+    stats_.oversized_allocations++;
+    stats_.reserved_bytes += bytes;
+    stats_.live_bytes += bytes;
+    return ::operator new(bytes);
+  }
+
+  SizeClass& size_class = classes_[ClassIndex(bytes)];
+  Slab* slab = size_class.partial.empty() ? CreateSlab(size_class)
+                                          : size_class.partial.back();
+  void* block = slab->free_head;
+  slab->free_head = *static_cast<void**>(block);
+  if (slab->live++ == 0) {
+    size_class.empty_slabs--;
+    stats_.empty_slabs--;
+  }
+  if (slab->free_head == nullptr) {
+    // partial.back() is always the slab we allocated from.
+    size_class.partial.pop_back();
+    slab->in_partial_list = false;
+  }
+
+  stats_.live_blocks++;
+  stats_.free_blocks--;
+  stats_.live_bytes += size_class.block_size;
+  return block;
+}
+
+void ChunkPayloadPool::Deallocate(void* ptr, size_t bytes) {
+  if (ptr == nullptr)
+    return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (bytes > kMaxBlockSize) {
+    stats_.oversized_allocations--;
+    stats_.reserved_bytes -= bytes;
+    stats_.live_bytes -= bytes;
+    ::operator delete(ptr);
+    return;
+  }
+
+  const char* block = static_cast<const char*>(ptr);
+  auto itr = slabs_.upper_bound(block);
+  --itr;
+  Slab* slab = itr->second.get();
+  SizeClass& size_class = classes_[ClassIndex(slab->block_size)];
+
+  *static_cast<void**>(ptr) = slab->free_head;
+  slab->free_head = ptr;
+  if (!slab->in_partial_list) {
+    size_class.partial.push_back(slab);
+    slab->in_partial_list = true;
+  }
+  stats_.live_blocks--;
+  stats_.free_blocks++;
+  stats_.live_bytes -= slab->block_size;
+
+  if (--slab->live == 0) {
+    size_class.empty_slabs++;
+    stats_.empty_slabs++;
+    if (size_class.empty_slabs > retained_empty_slabs_)
+      ReleaseSlab(size_class, slab);
+  }
+}
+
+void ChunkPayloadPool::SetMemoryCap(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  memory_cap_ = bytes;
+}
+
+size_t ChunkPayloadPool::GetMemoryCap() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return memory_cap_;
+}
+
+void ChunkPayloadPool::SetRetainedEmptySlabs(size_t count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  retained_empty_slabs_ = count;
+  for (auto& size_class : classes_) {
+    // Release from a copy; ReleaseSlab edits the partial list.
+    std::vector<Slab*> candidates = size_class.partial;
+    for (Slab* slab : candidates) {
+      if (size_class.empty_slabs <= retained_empty_slabs_)
+        break;
+      if (slab->live == 0)
+        ReleaseSlab(size_class, slab);
+    }
+  }
+}
+
+ChunkPayloadPoolStats ChunkPayloadPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+}  // namespace GLOO
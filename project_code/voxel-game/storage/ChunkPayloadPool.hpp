@@ -0,0 +1,134 @@
+#ifndef CHUNK_PAYLOAD_POOL_H_
+#define CHUNK_PAYLOAD_POOL_H_
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace GLOO {
+struct ChunkPayloadPoolStats {
+  // Blocks currently handed out, and the bytes they cover (rounded up to
+  // their size class).
+  size_t live_blocks = 0;
+  size_t live_bytes = 0;
+  // Blocks sitting in the free lists of allocated slabs.
+  size_t free_blocks = 0;
+  size_t slabs = 0;
+  size_t empty_slabs = 0;
+  // Bytes held by slabs plus oversized allocations; this is what the cap
+  // bounds.
+  size_t reserved_bytes = 0;
+  // Requests too large for any size class, served by operator new.
+  size_t oversized_allocations = 0;
+};
+
+// Slab allocator for chunk payloads (packed voxel words, palettes, ...).
+// Requests are rounded up to power-of-two size classes between kMinBlockSize
+// and kMaxBlockSize. Each class carves fixed-size blocks out of large slabs
+// and keeps freed blocks on per-slab free lists, so chunks streaming in and
+// out recycle the same memory instead of going through the general-purpose
+// heap. Fully empty slabs beyond a small retained reserve are returned to
+// the system.
+//
+// Total reserved memory is bounded by a configurable cap; allocations that
+// would exceed it throw std::bad_alloc. The pool is thread-safe.
+class ChunkPayloadPool {
+ public:
+  static const size_t kMinBlockSize = 64;
+  static const size_t kMaxBlockSize = 64 * 1024;
+
+  // Singleton design pattern, like InputManager.
+  static ChunkPayloadPool& GetInstance() {
+    static ChunkPayloadPool _instance;
+    return _instance;
+  }
+
+  ChunkPayloadPool(const ChunkPayloadPool&) = delete;
+  void operator=(const ChunkPayloadPool&) = delete;
+
+  void* Allocate(size_t bytes);
+  // bytes must be the size passed to Allocate.
+  void Deallocate(void* ptr, size_t bytes);
+
+  // A cap of 0 means unbounded. Lowering the cap below the current
+  // reservation does not free anything; it only blocks further growth.
+  void SetMemoryCap(size_t bytes);
+  size_t GetMemoryCap() const;
+  // Number of empty slabs each size class keeps around for reuse.
+  void SetRetainedEmptySlabs(size_t count);
+
+  ChunkPayloadPoolStats GetStats() const;
+
+ private:
+  struct Slab {
+    std::unique_ptr<char[]> memory;
+    size_t block_size;
+    size_t block_count;
+    size_t live;
+    // Intrusive singly linked list threaded through the free blocks.
+    void* free_head;
+    bool in_partial_list;
+  };
+
+  struct SizeClass {
+    size_t block_size;
+    // Slabs with at least one free block.
+    std::vector<Slab*> partial;
+    size_t empty_slabs;
+  };
+
+  ChunkPayloadPool();
+
+  static size_t ClassIndex(size_t bytes);
+  Slab* CreateSlab(SizeClass& size_class);
+  void ReleaseSlab(SizeClass& size_class, Slab* slab);
+  bool CanReserve(size_t bytes) const;
+
+  mutable std::mutex mutex_;
+  std::vector<SizeClass> classes_;
+  // All slabs keyed by their start address, to find the owner of a block.
+  std::map<const char*, std::unique_ptr<Slab>> slabs_;
+  size_t memory_cap_;
+  size_t retained_empty_slabs_;
+  ChunkPayloadPoolStats stats_;
+};
+
+// STL allocator drawing from ChunkPayloadPool, for payload containers.
+template <typename T>
+struct ChunkPayloadAllocator {
+  using value_type = T;
+
+  ChunkPayloadAllocator() {
+  }
+  template <typename U>
+  ChunkPayloadAllocator(const ChunkPayloadAllocator<U>&) {
+  }
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(
+        ChunkPayloadPool::GetInstance().Allocate(n * sizeof(T)));
+  }
+  void deallocate(T* ptr, size_t n) {
+    ChunkPayloadPool::GetInstance().Deallocate(ptr, n * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const ChunkPayloadAllocator<T>&,
+                const ChunkPayloadAllocator<U>&) {
+  return true;
+}
+template <typename T, typename U>
+bool operator!=(const ChunkPayloadAllocator<T>&,
+                const ChunkPayloadAllocator<U>&) {
+  return false;
+}
+
+template <typename T>
+using PayloadVector = std::vector<T, ChunkPayloadAllocator<T>>;
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,169 @@
+#include "ChunkResidencyManager.hpp"
+
+#include <algorithm>
+
+namespace GLOO {
+namespace {
+// Rebuild the load queue when the view direction turns by more than ~30
+// degrees since the last rebuild.
+const float kRequeueCosine = 0.866f;
+// Chunks straight behind the viewer are loaded as if they were this many
+// times farther away.
+const float kBehindPenalty = 2.0f;
+// Loading resumes only once resident memory drops below this fraction of
+// the budget. Evictions stop at the budget itself, so the gap keeps the
+// manager from evicting and reloading the same chunks every frame.
+const double kLoadWatermark = 0.9;
+
+glm::vec3 SafeNormalize(const glm::vec3& v) {
+  float length = glm::length(v);
+  return length > 1e-6f ? v / length : glm::vec3(0.0f);
+}
+}  // namespace
+
+ChunkResidencyManager::ChunkResidencyManager(const ResidencySettings& settings)
+    : settings_(settings),
+      viewer_position_(0.0f),
+      viewer_forward_(0.0f, 0.0f, -1.0f),
+      center_(0),
+      queue_forward_(0.0f),
+      queue_valid_(false),
+      frame_(0) {
+}
+
+void ChunkResidencyManager::SetSettings(const ResidencySettings& settings) {
+  settings_ = settings;
+  queue_valid_ = false;
+}
+
+bool ChunkResidencyManager::WithinLoadRadius(const ChunkCoord& coord) const {
+  glm::ivec3 d = coord - center_;
+  return d.x * d.x + d.z * d.z <=
+             settings_.load_radius * settings_.load_radius &&
+         std::abs(d.y) <= settings_.vertical_load_radius;
+}
+
+bool ChunkResidencyManager::WithinUnloadRadius(const ChunkCoord& coord) const {
+  glm::ivec3 d = coord - center_;
+  return d.x * d.x + d.z * d.z <=
+             settings_.unload_radius * settings_.unload_radius &&
+         std::abs(d.y) <= settings_.vertical_unload_radius;
+}
+
+float ChunkResidencyManager::DistanceToViewer(const ChunkCoord& coord) const {
+  glm::vec3 chunk_center =
+      glm::vec3(ChunkOrigin(coord)) + glm::vec3(kChunkSize * 0.5f);
+  return glm::length(chunk_center - viewer_position_) / kChunkSize;
+}
+
+float ChunkResidencyManager::LoadPriority(const ChunkCoord& coord) const {
+  glm::vec3 chunk_center =
+      glm::vec3(ChunkOrigin(coord)) + glm::vec3(kChunkSize * 0.5f);
+  glm::vec3 to_chunk = SafeNormalize(chunk_center - viewer_position_);
+  // 0 for chunks straight ahead, 1 for chunks straight behind.
+  float behind = 0.5f * (1.0f - glm::dot(to_chunk, viewer_forward_));
+  return DistanceToViewer(coord) * (1.0f + (kBehindPenalty - 1.0f) * behind);
+}
+
+void ChunkResidencyManager::Update(const glm::vec3& position,
+                                   const glm::vec3& forward,
+                                   const ChunkPredicate& is_loaded) {
+  frame_++;
+  viewer_position_ = position;
+  viewer_forward_ = SafeNormalize(forward);
+
+  ChunkCoord center = WorldToChunkCoord(glm::ivec3(glm::floor(position)));
+  if (center != center_ ||
+      glm::dot(viewer_forward_, queue_forward_) < kRequeueCosine) {
+    center_ = center;
+    queue_valid_ = false;
+  }
+
+  for (auto& entry : last_used_) {
+    if (WithinLoadRadius(entry.first))
+      entry.second = frame_;
+  }
+
+  if (!queue_valid_)
+    RebuildLoadQueue(is_loaded);
+}
+
+void ChunkResidencyManager::RebuildLoadQueue(const ChunkPredicate& is_loaded) {
+  load_queue_ = std::priority_queue<LoadRequest>();
+  int r = settings_.load_radius;
+  int vr = settings_.vertical_load_radius;
+  for (int dz = -r; dz <= r; dz++) {
+    for (int dy = -vr; dy <= vr; dy++) {
+      for (int dx = -r; dx <= r; dx++) {
+        ChunkCoord coord = center_ + glm::ivec3(dx, dy, dz);
+        if (!WithinLoadRadius(coord) || last_used_.count(coord) ||
+            is_loaded(coord))
+          continue;
+        load_queue_.push({LoadPriority(coord), coord});
+      }
+    }
+  }
+  queue_forward_ = viewer_forward_;
+  queue_valid_ = true;
+}
+
+std::vector<ChunkCoord> ChunkResidencyManager::TakeLoadRequests(
+    size_t memory_usage) {
+  std::vector<ChunkCoord> requests;
+  if (memory_usage >= settings_.memory_budget * kLoadWatermark)
+    return requests;
+  while (!load_queue_.empty() &&
+         requests.size() < settings_.max_loads_per_update) {
+    ChunkCoord coord = load_queue_.top().coord;
+    load_queue_.pop();
+    // The queue may be stale if chunks were loaded behind our back.
+    if (last_used_.count(coord) == 0 && WithinLoadRadius(coord))
+      requests.push_back(coord);
+  }
+  return requests;
+}
+
+std::vector<ChunkCoord> ChunkResidencyManager::CollectEvictions(
+    size_t memory_usage,
+    const ChunkBytes& chunk_bytes) {
+  std::vector<ChunkCoord> evictions;
+  std::vector<ChunkCoord> candidates;
+  for (const auto& entry : last_used_) {
+    if (!WithinUnloadRadius(entry.first)) {
+      evictions.push_back(entry.first);
+      memory_usage -= std::min(memory_usage, chunk_bytes(entry.first));
+    } else {
+      candidates.push_back(entry.first);
+    }
+  }
+  if (memory_usage <= settings_.memory_budget)
+    return evictions;
+
+  std::sort(candidates.begin(), candidates.end(),
+            [this](const ChunkCoord& a, const ChunkCoord& b) {
+              uint64_t used_a = last_used_.at(a), used_b = last_used_.at(b);
+              if (used_a != used_b)
+                return used_a < used_b;
+              return DistanceToViewer(a) > DistanceToViewer(b);
+            });
+  for (const ChunkCoord& coord : candidates) {
+    if (memory_usage <= settings_.memory_budget)
+      break;
+    evictions.push_back(coord);
+    memory_usage -= std::min(memory_usage, chunk_bytes(coord));
+  }
+  return evictions;
+}
+
+void ChunkResidencyManager::OnChunkLoaded(const ChunkCoord& coord) {
+  last_used_[coord] = frame_;
+}
+
+void ChunkResidencyManager::OnChunkUnloaded(const ChunkCoord& coord) {
+  last_used_.erase(coord);
+  // An evicted chunk inside the load radius has to be queued again once
+  // there is room for it.
+  if (WithinLoadRadius(coord))
+    queue_valid_ = false;
+}
+}  // namespace GLOO
@@ -0,0 +1,109 @@
+#ifndef CHUNK_RESIDENCY_MANAGER_H_
+#define CHUNK_RESIDENCY_MANAGER_H_
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.hpp"
+
+namespace GLOO {
+struct ResidencySettings {
+  // Radii are in chunks. Horizontal distance is measured in the xz-plane.
+  // The unload radii are larger than the load radii so a viewer moving back
+  // and forth across a chunk border does not keep reloading the same chunks.
+  // Distant chunks mesh at coarse levels of detail, which is what makes a
+  // load radius this far affordable.
+  int load_radius = 8;
+  int unload_radius = 10;
+  int vertical_load_radius = 2;
+  int vertical_unload_radius = 3;
+  // Upper bound on the voxel payload of resident chunks, in bytes. When it
+  // is exceeded, least recently used chunks are evicted first and no new
+  // chunks are loaded.
+  size_t memory_budget = 256 * 1024 * 1024;
+  // Loads handed out per TakeLoadRequests() call.
+  size_t max_loads_per_update = 8;
+};
+
+// Decides which chunks should be resident around a viewer. The manager does
+// not own chunk data: the world reports loads and unloads back to it and
+// carries out the requests it hands out.
+class ChunkResidencyManager {
+ public:
+  using ChunkPredicate = std::function<bool(const ChunkCoord&)>;
+  using ChunkBytes = std::function<size_t(const ChunkCoord&)>;
+
+  explicit ChunkResidencyManager(
+      const ResidencySettings& settings = ResidencySettings());
+
+  void SetSettings(const ResidencySettings& settings);
+  const ResidencySettings& GetSettings() const {
+    return settings_;
+  }
+
+  // Re-centers on the viewer. Resident chunks inside the load radius count
+  // as used this frame. The load queue is rebuilt when the viewer enters a
+  // new chunk or turns noticeably; missing chunks are queued nearest and
+  // most in-view first.
+  void Update(const glm::vec3& position,
+              const glm::vec3& forward,
+              const ChunkPredicate& is_loaded);
+
+  // Pops the next chunks to load, in priority order. Returns nothing while
+  // resident memory is close to the budget.
+  std::vector<ChunkCoord> TakeLoadRequests(size_t memory_usage);
+
+  // Chunks to unload: everything beyond the unload radius, then least
+  // recently used chunks (farthest first on ties) until memory_usage fits
+  // the budget again.
+  std::vector<ChunkCoord> CollectEvictions(size_t memory_usage,
+                                           const ChunkBytes& chunk_bytes);
+
+  void OnChunkLoaded(const ChunkCoord& coord);
+  void OnChunkUnloaded(const ChunkCoord& coord);
+
+  // Whether a chunk may stay resident, or keep loading, where the viewer
+  // is now.
+  bool WithinUnloadRadius(const ChunkCoord& coord) const;
+
+  size_t GetPendingLoadCount() const {
+    return load_queue_.size();
+  }
+  size_t GetResidentCount() const {
+    return last_used_.size();
+  }
+
+ private:
+  struct LoadRequest {
+    float priority;
+    ChunkCoord coord;
+    // std::priority_queue is a max-heap; invert so the lowest priority
+    // value comes out first.
+    bool operator<(const LoadRequest& other) const {
+      return priority > other.priority;
+    }
+  };
+
+  bool WithinLoadRadius(const ChunkCoord& coord) const;
+  float DistanceToViewer(const ChunkCoord& coord) const;
+  float LoadPriority(const ChunkCoord& coord) const;
+  void RebuildLoadQueue(const ChunkPredicate& is_loaded);
+
+  ResidencySettings settings_;
+  glm::vec3 viewer_position_;
+  glm::vec3 viewer_forward_;
+  ChunkCoord center_;
+  glm::vec3 queue_forward_;
+  bool queue_valid_;
+  uint64_t frame_;
+
+  std::priority_queue<LoadRequest> load_queue_;
+  // Resident chunks and the frame they were last within the load radius.
+  std::unordered_map<ChunkCoord, uint64_t, ChunkCoordHash> last_used_;
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef CHUNK_SNAPSHOT_H_
+#define CHUNK_SNAPSHOT_H_
+
+#include <memory>
+
+#include "Chunk.hpp"
+
+namespace GLOO {
+// Immutable copy-on-write view of a chunk and its 26 neighbours, so passes
+// that look across chunk borders (meshing, lighting) can run on a worker
+// thread while the world keeps being edited. Neighbours that were not
+// loaded read as air.
+class ChunkNeighborhood {
+ public:
+  static const int kSpan = 3;
+  static const int kCount = kSpan * kSpan * kSpan;
+
+  ChunkNeighborhood() : center_(0) {
+  }
+  explicit ChunkNeighborhood(const ChunkCoord& center) : center_(center) {
+  }
+
+  const ChunkCoord& GetCenter() const {
+    return center_;
+  }
+
+  // offset is relative to the center chunk, each component in [-1, 1].
+  void SetChunk(const glm::ivec3& offset,
+                std::shared_ptr<const VoxelStorage> storage) {
+    chunks_[SlotIndex(offset.x + 1, offset.y + 1, offset.z + 1)] =
+        std::move(storage);
+  }
+  const VoxelStorage* GetChunk(const glm::ivec3& offset) const {
+    return chunks_[SlotIndex(offset.x + 1, offset.y + 1, offset.z + 1)].get();
+  }
+  const VoxelStorage* GetCenterChunk() const {
+    return chunks_[SlotIndex(1, 1, 1)].get();
+  }
+
+  // Coordinates are local to the center chunk and may reach into the
+  // neighbours: each component must lie in [-kChunkSize, 2 * kChunkSize).
+  VoxelType Get(int x, int y, int z) const {
+    int sx = (x + kChunkSize) >> kChunkSizeLog2;
+    int sy = (y + kChunkSize) >> kChunkSizeLog2;
+    int sz = (z + kChunkSize) >> kChunkSizeLog2;
+    const VoxelStorage* storage = chunks_[SlotIndex(sx, sy, sz)].get();
+    if (storage == nullptr)
+      return VoxelType::Air;
+    return storage->Get(
+        Chunk::Index(x & kChunkMask, y & kChunkMask, z & kChunkMask));
+  }
+
+ private:
+  static int SlotIndex(int sx, int sy, int sz) {
+    return sx + kSpan * (sy + kSpan * sz);
+  }
+
+  ChunkCoord center_;
+  std::shared_ptr<const VoxelStorage> chunks_[kCount];
+};
+}  // namespace GLOO
+
+#endif
@@ -0,0 +1,178 @@
+#include "VoxelStorage.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace GLOO {
+namespace {
+const int kMaxBitsPerIndex = 16;
+
+unsigned Log2(unsigned value) {
+  unsigned result = 0;
+  while (value >>= 1)
+    result++;
+  return result;
+}
+
+// Reads an index from a packing that is not (or no longer) the current one.
+uint32_t ReadPacked(const PayloadVector<uint64_t>& words,
+                    unsigned bits_log2,
+                    size_t index) {
+  unsigned entries_per_word_log2 = 6 - bits_log2;
+  size_t word = index >> entries_per_word_log2;
+  unsigned shift = static_cast<unsigned>(
+                       index & ((size_t(1) << entries_per_word_log2) - 1))
+                   << bits_log2;
+  uint64_t mask = (uint64_t(1) << (1u << bits_log2)) - 1;
+  return static_cast<uint32_t>((words[word] >> shift) & mask);
+}
+}  // namespace
+
+VoxelStorage::VoxelStorage(size_t volume, VoxelType fill) : volume_(volume) {
+  Fill(fill);
+}
+
+void VoxelStorage::SetBits(int bits) {
+  bits_ = bits;
+  if (bits == 0) {
+    bits_log2_ = 0;
+    entries_per_word_log2_ = 0;
+    entries_per_word_mask_ = 0;
+    index_mask_ = 0;
+    return;
+  }
+  bits_log2_ = Log2(static_cast<unsigned>(bits));
+  entries_per_word_log2_ = 6 - bits_log2_;
+  entries_per_word_mask_ = (size_t(1) << entries_per_word_log2_) - 1;
+  index_mask_ = (uint64_t(1) << bits) - 1;
+}
+
+int VoxelStorage::BitsForPaletteSize(size_t palette_size) {
+  int bits = 1;
+  while ((size_t(1) << bits) < palette_size)
+    bits <<= 1;
+  if (bits > kMaxBitsPerIndex)
+    throw std::runtime_error("Voxel palette exceeds 16-bit indices!");
+  return bits;
+}
+
+void VoxelStorage::Fill(VoxelType type) {
+  uniform_type_ = type;
+  PayloadVector<VoxelType>().swap(palette_);
+  PayloadVector<uint32_t>().swap(counts_);
+  PayloadVector<uint64_t>().swap(words_);
+  SetBits(0);
+}
+
+void VoxelStorage::Promote() {
+  palette_.assign(1, uniform_type_);
+  counts_.assign(1, static_cast<uint32_t>(volume_));
+  SetBits(1);
+  words_.assign(((volume_ << bits_log2_) + 63) / 64, 0);
+}
+
+void VoxelStorage::Set(size_t index, VoxelType type) {
+  if (bits_ == 0) {
+    if (type == uniform_type_)
+      return;
+    Promote();
+  }
+  uint32_t old_index = ReadIndex(index);
+  if (palette_[old_index] == type)
+    return;
+  // Release the old entry first so that a voxel replacing the last user of
+  // an entry can take over its slot without growing the palette.
+  counts_[old_index]--;
+  uint32_t new_index = FindOrAddPaletteEntry(type);
+  counts_[new_index]++;
+  WriteIndex(index, new_index);
+}
+
+uint32_t VoxelStorage::FindOrAddPaletteEntry(VoxelType type) {
+  size_t free_slot = palette_.size();
+  for (size_t i = 0; i < palette_.size(); i++) {
+    if (counts_[i] > 0 && palette_[i] == type)
+      return static_cast<uint32_t>(i);
+    if (counts_[i] == 0 && free_slot == palette_.size())
+      free_slot = i;
+  }
+  if (free_slot < palette_.size()) {
+    palette_[free_slot] = type;
+    return static_cast<uint32_t>(free_slot);
+  }
+
+  palette_.push_back(type);
+  counts_.push_back(0);
+  if (palette_.size() > (size_t(1) << bits_)) {
+    std::vector<uint32_t> identity(palette_.size());
+    for (size_t i = 0; i < identity.size(); i++)
+      identity[i] = static_cast<uint32_t>(i);
+    Repack(BitsForPaletteSize(palette_.size()), identity);
+  }
+  return static_cast<uint32_t>(palette_.size() - 1);
+}
+
+void VoxelStorage::Repack(int new_bits, const std::vector<uint32_t>& remap) {
+  PayloadVector<uint64_t> old_words;
+  old_words.swap(words_);
+  unsigned old_bits_log2 = bits_log2_;
+
+  SetBits(new_bits);
+  words_.assign(((volume_ << bits_log2_) + 63) / 64, 0);
+  for (size_t i = 0; i < volume_; i++)
+    WriteIndex(i, remap[ReadPacked(old_words, old_bits_log2, i)]);
+}
+
+void VoxelStorage::GetRange(size_t first, size_t count, VoxelType* out) const {
+  if (bits_ == 0) {
+    std::fill(out, out + count, uniform_type_);
+    return;
+  }
+  size_t index = first;
+  size_t end = first + count;
+  while (index < end) {
+    size_t word_index = index >> entries_per_word_log2_;
+    size_t word_end = std::min(end, (word_index + 1) << entries_per_word_log2_);
+    uint64_t word = words_[word_index] >>
+                    (static_cast<unsigned>(index & entries_per_word_mask_)
+                     << bits_log2_);
+    for (; index < word_end; index++) {
+      *out++ = palette_[static_cast<size_t>(word & index_mask_)];
+      word >>= bits_;
+    }
+  }
+}
+
+void VoxelStorage::Compact() {
+  if (bits_ == 0)
+    return;
+  std::vector<uint32_t> remap(palette_.size(), 0);
+  PayloadVector<VoxelType> new_palette;
+  PayloadVector<uint32_t> new_counts;
+  for (size_t i = 0; i < palette_.size(); i++) {
+    if (counts_[i] == 0)
+      continue;
+    remap[i] = static_cast<uint32_t>(new_palette.size());
+    new_palette.push_back(palette_[i]);
+    new_counts.push_back(counts_[i]);
+  }
+  if (new_palette.size() == 1) {
+    Fill(new_palette[0]);
+    return;
+  }
+
+  int new_bits = BitsForPaletteSize(new_palette.size());
+  if (new_palette.size() == palette_.size() && new_bits == bits_)
+    return;
+
+  Repack(new_bits, remap);
+  palette_ = std::move(new_palette);
+  counts_ = std::move(new_counts);
+}
+
+size_t VoxelStorage::GetMemoryUsage() const {
+  return words_.capacity() * sizeof(uint64_t) +
+         palette_.capacity() * sizeof(VoxelType) +
+         counts_.capacity() * sizeof(uint32_t);
+}
+}  // namespace GLOO
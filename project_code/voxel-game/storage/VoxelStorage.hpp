@@ -0,0 +1,108 @@
+#ifndef VOXEL_STORAGE_H_
+#define VOXEL_STORAGE_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "Voxel.hpp"
+#include "ChunkPayloadPool.hpp"
+
+namespace GLOO {
+// Palette-compressed voxel storage for a single chunk. Each voxel stores an
+// index into a small per-chunk palette of voxel types; the indices are
+// bit-packed into 64-bit words using 1, 2, 4, 8 or 16 bits per voxel. Widths
+// that divide 64 keep every index inside a single word, so reads are one load,
+// one shift and one mask.
+//
+// The index width grows when a new type no longer fits in the palette and
+// shrinks again in Compact(), which drops palette entries no voxel refers to.
+//
+// Storage holding a single voxel type (all air, all stone, ...) is kept in a
+// uniform state with zero bits per index: no palette and no packed words are
+// allocated. The first differing write promotes it to a 1-bit packing, and
+// Compact() demotes it again once only one type is left.
+//
+// All payload memory comes from ChunkPayloadPool.
+class VoxelStorage {
+ public:
+  explicit VoxelStorage(size_t volume, VoxelType fill = VoxelType::Air);
+
+  VoxelType Get(size_t index) const {
+    if (bits_ == 0)
+      return uniform_type_;
+    return palette_[ReadIndex(index)];
+  }
+  void Set(size_t index, VoxelType type);
+  // Decodes count consecutive voxels starting at first into out, one packed
+  // word at a time.
+  void GetRange(size_t first, size_t count, VoxelType* out) const;
+
+  // Overwrites every voxel with type, releasing the packed payload.
+  void Fill(VoxelType type);
+
+  // Removes unused palette entries and repacks with the narrowest width that
+  // still fits the palette, or demotes to the uniform state.
+  void Compact();
+
+  bool IsUniform() const {
+    return bits_ == 0;
+  }
+  // Only meaningful when IsUniform() is true.
+  VoxelType GetUniformType() const {
+    return uniform_type_;
+  }
+
+  size_t GetVolume() const {
+    return volume_;
+  }
+  int GetBitsPerIndex() const {
+    return bits_;
+  }
+  size_t GetPaletteSize() const {
+    return palette_.size();
+  }
+  // Approximate heap usage of the payload, in bytes.
+  size_t GetMemoryUsage() const;
+
+ private:
+  uint32_t ReadIndex(size_t index) const {
+    size_t word = index >> entries_per_word_log2_;
+    unsigned shift =
+        static_cast<unsigned>(index & entries_per_word_mask_) << bits_log2_;
+    return static_cast<uint32_t>((words_[word] >> shift) & index_mask_);
+  }
+  void WriteIndex(size_t index, uint32_t palette_index) {
+    size_t word = index >> entries_per_word_log2_;
+    unsigned shift =
+        static_cast<unsigned>(index & entries_per_word_mask_) << bits_log2_;
+    words_[word] = (words_[word] & ~(index_mask_ << shift)) |
+                   (static_cast<uint64_t>(palette_index) << shift);
+  }
+
+  // Returns the palette index for type, adding it to the palette (and
+  // widening the indices) if necessary.
+  uint32_t FindOrAddPaletteEntry(VoxelType type);
+  void Promote();
+  void Repack(int new_bits, const std::vector<uint32_t>& remap);
+  void SetBits(int bits);
+
+  static int BitsForPaletteSize(size_t palette_size);
+
+  size_t volume_;
+  VoxelType uniform_type_;
+  PayloadVector<VoxelType> palette_;
+  // Number of voxels referring to each palette entry. Entries with a zero
+  // count are reused before the palette grows.
+  PayloadVector<uint32_t> counts_;
+  PayloadVector<uint64_t> words_;
+
+  int bits_;
+  unsigned bits_log2_;
+  unsigned entries_per_word_log2_;
+  size_t entries_per_word_mask_;
+  uint64_t index_mask_;
+};
+}  // namespace GLOO
+
+#endif
@@ -1,87 +1,288 @@
 #include "world.hpp"
 
-#include "gloo/components/RenderingComponent.hpp"
-#include "gloo/components/ShadingComponent.hpp"
-#include "gloo/components/MaterialComponent.hpp"
-#include "gloo/shaders/PhongShader.hpp"
+#include "generation/TerrainGenerator.hpp"
 
 #include <iostream>
 #include <glm/gtx/string_cast.hpp>
 #include <stdlib.h>
+#include <cmath>
+#include <stdexcept>
 
 namespace GLOO
 {
-	World::World(long seed)
+	World::World(long seed) : seed_(seed)
 	{
-		voxels[0][0][0] = Voxel(VoxelType::Dirt);
-		shader_ = std::make_shared<PhongShader>();
-		world_mesh_ = std::make_shared<VertexObject>();
+		std::shared_ptr<const TerrainGenerator> terrain = std::make_shared<TerrainGenerator>(static_cast<uint64_t>(seed));
+		generator_ = [terrain](Chunk& chunk) { terrain->Generate(chunk); };
+		terrain_ = std::move(terrain);
 	}
 
-	void World::Render(SceneNode& root)
+	void World::SetGenerator(ChunkGenerator generator)
 	{
-		auto positions = make_unique<PositionArray>();
-		auto normals = make_unique<NormalArray>();
-		auto indices = make_unique<IndexArray>();
+		generator_ = std::move(generator);
+		terrain_.reset();
+		pipeline_.reset();
+	}
+
+	void World::SetGenerationPool(ThreadPool* pool)
+	{
+		pipeline_.reset();
+		if (pool != nullptr && terrain_ != nullptr)
+			pipeline_ = make_unique<ChunkGenerationPipeline>(*pool, terrain_);
+	}
+
+	bool World::Update(const glm::vec3& pos, const glm::vec3& forward)
+	{
+		residency_.Update(pos, forward, [this](const ChunkCoord& coord) {
+			return GetChunk(coord) != nullptr || (pipeline_ && pipeline_->IsRequested(coord));
+		});
+
+		bool changed = false;
+		std::vector<ChunkCoord> evictions = residency_.CollectEvictions(GetMemoryUsage(), [this](const ChunkCoord& coord) {
+			const Chunk* chunk = GetChunk(coord);
+			return chunk == nullptr ? size_t(0) : GetChunkMemoryUsage(*chunk);
+		});
+		for (const ChunkCoord& coord : evictions)
+			changed |= RemoveChunk(coord);
+
+		if (pipeline_)
+		{
+			// Chunks the viewer left behind before they finished are not
+			// wanted anymore.
+			pipeline_->CancelUnless([this](const ChunkCoord& coord) {
+				return residency_.WithinUnloadRadius(coord);
+			});
+			pipeline_->SetFocus(pos);
+			for (std::unique_ptr<Chunk>& chunk : pipeline_->TakeCompleted())
+				changed |= AddChunk(std::move(chunk));
+		}
 
-		for (int i = 0; i < WORLD_SIZE; i++)
+		for (const ChunkCoord& coord : residency_.TakeLoadRequests(GetMemoryUsage()))
 		{
-			for (int j = 0; j < WORLD_SIZE; j++)
+			if (pipeline_)
 			{
-				for (int k = 0; k < WORLD_SIZE; k++)
+				pipeline_->Request(coord);
+				continue;
+			}
+			GetOrCreateChunk(coord);
+			changed = true;
+		}
+		return changed;
+	}
+
+	size_t World::GetChunkMemoryUsage(const Chunk& chunk)
+	{
+		return sizeof(Chunk) + sizeof(VoxelStorage) + chunk.GetStorage().GetMemoryUsage();
+	}
+
+	size_t World::GetMemoryUsage() const
+	{
+		size_t total = 0;
+		for (const auto& entry : chunks_)
+			total += GetChunkMemoryUsage(*entry.second);
+		return total;
+	}
+
+	Voxel World::GetVoxel(const glm::ivec3& pos) const
+	{
+		const Chunk* chunk = GetChunk(WorldToChunkCoord(pos));
+		if (chunk == nullptr)
+			return Voxel(VoxelType::Air);
+		glm::ivec3 local = WorldToLocal(pos);
+		return chunk->Get(local.x, local.y, local.z);
+	}
+
+	void World::SetVoxel(const glm::ivec3& pos, const Voxel& voxel)
+	{
+		Chunk& chunk = GetOrCreateChunk(WorldToChunkCoord(pos));
+		glm::ivec3 local = WorldToLocal(pos);
+		if (chunk.Set(local.x, local.y, local.z, voxel))
+			dirty_chunks_.insert(chunk.GetCoord());
+	}
+
+	template <typename Fn>
+	void World::ForEachChunkInBox(const glm::ivec3& min, const glm::ivec3& max, bool create, Fn fn)
+	{
+		if (min.x >= max.x || min.y >= max.y || min.z >= max.z)
+			return;
+		ChunkCoord first = WorldToChunkCoord(min);
+		ChunkCoord last = WorldToChunkCoord(max - 1);
+		for (int cz = first.z; cz <= last.z; cz++)
+		{
+			for (int cy = first.y; cy <= last.y; cy++)
+			{
+				for (int cx = first.x; cx <= last.x; cx++)
 				{
-					
-					// only for one voxel for now
-
-					positions->push_back(glm::vec3(i, j, k));
-					positions->push_back(glm::vec3(i+1, j, k));
-					positions->push_back(glm::vec3(i, j+1, k));
-					positions->push_back(glm::vec3(i+1, j+1, k));
-					positions->push_back(glm::vec3(i, j+1, k+1));
-					positions->push_back(glm::vec3(i+1, j+1, k+1));
-					positions->push_back(glm::vec3(i, j, k+1));
-					positions->push_back(glm::vec3(i+1, j, k+1));
-
-					normals->push_back(glm::vec3(0, 0, -1));
-					normals->push_back(glm::vec3(0, 0, -1));
-					normals->push_back(glm::vec3(0, 1, 0));
-					normals->push_back(glm::vec3(0, 1, 0));
-					normals->push_back(glm::vec3(0, 0, 1));
-					normals->push_back(glm::vec3(0, 0, 1));
-					normals->push_back(glm::vec3(0, -1, 0));
-					normals->push_back(glm::vec3(0, -1, 0));
-					normals->push_back(glm::vec3(-1, 0, 0));
-					normals->push_back(glm::vec3(-1, 0, 0));
-					normals->push_back(glm::vec3(1, 0, 0));
-					normals->push_back(glm::vec3(1, 0, 0));
-
-					auto index_nums = {	0, 1, 2, 1, 2, 3, 
-										2, 3, 4, 3, 4, 5, 
-										4, 5, 6, 5, 6, 7,
-										6, 7, 0, 7, 0, 1, 
-										0, 2, 6, 2, 6, 4, 
-										1, 3, 7, 3, 7, 5 };
-					indices->insert(indices->end(), index_nums.begin(), index_nums.end());
-
-					world_mesh_->UpdatePositions(std::move(positions));
-					world_mesh_->UpdateNormals(std::move(normals));
-					world_mesh_->UpdateIndices(std::move(indices));
+					ChunkCoord coord(cx, cy, cz);
+					Chunk* chunk = create ? &GetOrCreateChunk(coord) : GetChunk(coord);
+					if (chunk == nullptr)
+						continue;
+					glm::ivec3 origin = chunk->GetOrigin();
+					glm::ivec3 local_min = glm::max(min - origin, glm::ivec3(0));
+					glm::ivec3 local_max = glm::min(max - origin, glm::ivec3(kChunkSize));
+					if (fn(*chunk, local_min, local_max) > 0)
+						dirty_chunks_.insert(coord);
 				}
 			}
 		}
-		
+	}
 
-		auto mesh_node = make_unique<SceneNode>();
-		mesh_node->CreateComponent<ShadingComponent>(shader_);
-		mesh_node->CreateComponent<RenderingComponent>(world_mesh_);
-		mesh_node->GetComponentPtr<RenderingComponent>()->SetDrawMode(DrawMode::Triangles);
-		mesh_node->CreateComponent<MaterialComponent>(std::make_shared<Material>(glm::vec3(0.5f), glm::vec3(0.5f), glm::vec3(0.5f), 1.0f));
+	void World::FillBox(const glm::ivec3& min, const glm::ivec3& max, const Voxel& voxel)
+	{
+		VoxelType type = voxel.getType();
+		ForEachChunkInBox(min, max, true, [type](Chunk& chunk, const glm::ivec3& lo, const glm::ivec3& hi) -> int {
+			if (lo == glm::ivec3(0) && hi == glm::ivec3(kChunkSize))
+			{
+				// Whole chunk covered: drop the payload instead of writing
+				// every voxel.
+				bool changed = !(chunk.IsUniform() && chunk.GetUniformVoxel().getType() == type);
+				chunk.Fill(Voxel(type));
+				return changed ? kChunkVolume : 0;
+			}
+			return chunk.EditRegion(lo, hi, [type](int, int, int, VoxelType) -> VoxelType { return type; });
+		});
+	}
 
-		root.AddChild(std::move(mesh_node));
+	void World::FillSphere(const glm::ivec3& center, float radius, const Voxel& voxel)
+	{
+		VoxelType type = voxel.getType();
+		int extent = static_cast<int>(std::ceil(radius));
+		float radius_sq = radius * radius;
+		glm::ivec3 min = center - glm::ivec3(extent);
+		glm::ivec3 max = center + glm::ivec3(extent + 1);
+		ForEachChunkInBox(min, max, true, [&](Chunk& chunk, const glm::ivec3& lo, const glm::ivec3& hi) -> int {
+			glm::ivec3 offset = chunk.GetOrigin() - center;
+			return chunk.EditRegion(lo, hi, [&](int x, int y, int z, VoxelType current) -> VoxelType {
+				glm::vec3 d(offset + glm::ivec3(x, y, z));
+				return glm::dot(d, d) <= radius_sq ? type : current;
+			});
+		});
 	}
 
-	void World::Update(glm::vec3(pos))
+	void World::ReplaceInBox(const glm::ivec3& min, const glm::ivec3& max, const Voxel& from, const Voxel& to)
 	{
+		VoxelType from_type = from.getType();
+		VoxelType to_type = to.getType();
+		// Unloaded chunks read as air, so replacing air has to create them.
+		bool create = from_type == VoxelType::Air;
+		ForEachChunkInBox(min, max, create, [&](Chunk& chunk, const glm::ivec3& lo, const glm::ivec3& hi) -> int {
+			if (chunk.IsUniform() && chunk.GetUniformVoxel().getType() != from_type)
+				return 0;
+			return chunk.EditRegion(lo, hi, [&](int, int, int, VoxelType current) -> VoxelType {
+				return current == from_type ? to_type : current;
+			});
+		});
+	}
+
+	void World::Paste(const glm::ivec3& origin, const glm::ivec3& size, const std::vector<Voxel>& voxels, bool skip_air)
+	{
+		if (voxels.size() < static_cast<size_t>(size.x) * size.y * size.z)
+			throw std::runtime_error("Paste buffer is smaller than its size!");
+		ForEachChunkInBox(origin, origin + size, true, [&](Chunk& chunk, const glm::ivec3& lo, const glm::ivec3& hi) -> int {
+			glm::ivec3 offset = chunk.GetOrigin() - origin;
+			return chunk.EditRegion(lo, hi, [&](int x, int y, int z, VoxelType current) -> VoxelType {
+				glm::ivec3 p = offset + glm::ivec3(x, y, z);
+				VoxelType type = voxels[p.x + size.x * (p.y + size.y * p.z)].getType();
+				return skip_air && type == VoxelType::Air ? current : type;
+			});
+		});
+	}
+
+	std::vector<ChunkEdit> World::TakeDirtyChunks()
+	{
+		std::vector<ChunkEdit> edits;
+		edits.reserve(dirty_chunks_.size());
+		for (const ChunkCoord& coord : dirty_chunks_)
+		{
+			Chunk* chunk = GetChunk(coord);
+			if (chunk == nullptr || !chunk->IsDirty())
+				continue;
+			edits.push_back({coord, chunk->GetDirtyRegion()});
+			chunk->ClearDirty();
+			// Compacted before the caller snapshots it for meshing, so a chunk
+			// edited back to uniform drops its palette and payload.
+			chunk->Compact();
+		}
+		dirty_chunks_.clear();
+		return edits;
+	}
+
+	Chunk* World::GetChunk(const ChunkCoord& coord)
+	{
+		auto itr = chunks_.find(coord);
+		return itr == chunks_.end() ? nullptr : itr->second.get();
+	}
+
+	const Chunk* World::GetChunk(const ChunkCoord& coord) const
+	{
+		auto itr = chunks_.find(coord);
+		return itr == chunks_.end() ? nullptr : itr->second.get();
+	}
+
+	Chunk& World::GetOrCreateChunk(const ChunkCoord& coord)
+	{
+		Chunk* existing = GetChunk(coord);
+		if (existing != nullptr)
+			return *existing;
+		// Edits cannot wait for the pipeline. Generation is deterministic,
+		// so the chunk comes out as the pipeline would have made it.
+		if (pipeline_)
+			pipeline_->Cancel(coord);
+		std::unique_ptr<Chunk> chunk = make_unique<Chunk>(coord);
+		if (generator_)
+			generator_(*chunk);
+		Chunk& result = *chunk;
+		AddChunk(std::move(chunk));
+		return result;
+	}
 
+	bool World::AddChunk(std::unique_ptr<Chunk> chunk)
+	{
+		ChunkCoord coord = chunk->GetCoord();
+		std::unique_ptr<Chunk>& slot = chunks_[coord];
+		if (slot != nullptr)
+			return false;
+		// Generated content is not an edit.
+		chunk->ClearDirty();
+		slot = std::move(chunk);
+		residency_.OnChunkLoaded(coord);
+		residency_changes_.push_back(coord);
+		return true;
+	}
+
+	bool World::RemoveChunk(const ChunkCoord& coord)
+	{
+		dirty_chunks_.erase(coord);
+		if (chunks_.erase(coord) == 0)
+			return false;
+		residency_.OnChunkUnloaded(coord);
+		residency_changes_.push_back(coord);
+		return true;
+	}
+
+	std::vector<ChunkCoord> World::TakeResidencyChanges()
+	{
+		std::vector<ChunkCoord> changes;
+		changes.swap(residency_changes_);
+		return changes;
+	}
+
+	ChunkNeighborhood World::SnapshotNeighborhood(const ChunkCoord& coord) const
+	{
+		ChunkNeighborhood neighborhood(coord);
+		for (int dz = -1; dz <= 1; dz++)
+		{
+			for (int dy = -1; dy <= 1; dy++)
+			{
+				for (int dx = -1; dx <= 1; dx++)
+				{
+					glm::ivec3 offset(dx, dy, dz);
+					const Chunk* chunk = GetChunk(coord + offset);
+					if (chunk != nullptr)
+						neighborhood.SetChunk(offset, chunk->Snapshot());
+				}
+			}
+		}
+		return neighborhood;
 	}
 }  // namespace GLOO
@@ -1,23 +1,121 @@
 #ifndef WORLD_H
 #define WORLD_H
 
-#include "gloo/SceneNode.hpp"
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "gloo/utils.hpp"
 #include "Voxel.hpp"
-#include "gloo/VertexObject.hpp"
-#include "gloo/shaders/PhongShader.hpp"
+#include "storage/Chunk.hpp"
+#include "storage/ChunkSnapshot.hpp"
+#include "storage/ChunkResidencyManager.hpp"
+#include "generation/ChunkGenerationPipeline.hpp"
 
 namespace GLOO
 {
+	// Edits accumulated in one chunk since the last TakeDirtyChunks().
+	struct ChunkEdit
+	{
+		ChunkCoord coord;
+		ChunkDirtyRegion region;
+	};
+
 	class World
 	{
 	public:
+		using ChunkMap = std::unordered_map<ChunkCoord, std::unique_ptr<Chunk>, ChunkCoordHash>;
+		// Fills a freshly created chunk.
+		using ChunkGenerator = std::function<void(Chunk&)>;
+
+		// Terrain comes from a TerrainGenerator seeded with seed.
 		World(long seed);
-		void Render(SceneNode& root);
-		void Update(glm::vec3(pos));
-		static const int WORLD_SIZE = 1;
-		Voxel voxels[WORLD_SIZE][WORLD_SIZE][WORLD_SIZE];
-		std::shared_ptr<ShaderProgram>shader_;
-		std::shared_ptr<VertexObject>world_mesh_;
+		// Streams chunks around the viewer: unloads chunks that left the
+		// unload radius or do not fit the memory budget, then generates the
+		// most urgent missing ones, or with a generation pool, adds the
+		// chunks finished since the last update and requests the most urgent
+		// missing ones. Returns whether the set of loaded chunks changed.
+		bool Update(const glm::vec3& pos, const glm::vec3& forward = glm::vec3(0.0f, 0.0f, -1.0f));
+
+		// Replaces the built-in terrain. Custom generators always run
+		// synchronously, so this also turns the generation pool off.
+		void SetGenerator(ChunkGenerator generator);
+		// Generates streamed chunks in stages on pool, nearest to the viewer
+		// first, instead of inside Update; nullptr goes back to generating
+		// synchronously. The pool must stay alive while the world is updated.
+		// Chunks created by edits are still generated on the spot, with
+		// identical results.
+		void SetGenerationPool(ThreadPool* pool);
+		// Chunks requested from the generation pool and not added yet.
+		size_t GetPendingGenerationCount() const { return pipeline_ ? pipeline_->GetPendingCount() : 0; }
+		long GetSeed() const { return seed_; }
+		ChunkResidencyManager& GetResidency() { return residency_; }
+		// Approximate memory held by the loaded chunks, in bytes.
+		size_t GetMemoryUsage() const;
+
+		// Voxel access by world coordinate. Reads from chunks that are not
+		// loaded return air; writes create the chunk on demand.
+		Voxel GetVoxel(const glm::ivec3& pos) const;
+		void SetVoxel(const glm::ivec3& pos, const Voxel& voxel);
+
+		// Batched region edits. Boxes are half-open, [min, max), in world
+		// coordinates. Each touched chunk is written span by span and records
+		// one dirty box, so consumers process one update per chunk rather
+		// than one per voxel.
+		void FillBox(const glm::ivec3& min, const glm::ivec3& max, const Voxel& voxel);
+		void FillSphere(const glm::ivec3& center, float radius, const Voxel& voxel);
+		void ReplaceInBox(const glm::ivec3& min, const glm::ivec3& max, const Voxel& from, const Voxel& to);
+		// voxels is x-major with dimensions size. With skip_air, air in the
+		// buffer leaves the world untouched.
+		void Paste(const glm::ivec3& origin, const glm::ivec3& size, const std::vector<Voxel>& voxels, bool skip_air = false);
+
+		// Returns the chunks edited since the last call together with their
+		// dirty boxes, and resets them. Each returned chunk is compacted, and
+		// demoted to a uniform chunk if the edits left it all one voxel.
+		std::vector<ChunkEdit> TakeDirtyChunks();
+		bool HasDirtyChunks() const { return !dirty_chunks_.empty(); }
+
+		Chunk* GetChunk(const ChunkCoord& coord);
+		const Chunk* GetChunk(const ChunkCoord& coord) const;
+		// Creates missing chunks through the generator, so edits land on top
+		// of generated terrain.
+		Chunk& GetOrCreateChunk(const ChunkCoord& coord);
+		bool RemoveChunk(const ChunkCoord& coord);
+		// Returns the chunks loaded or unloaded since the last call, in
+		// order; a coordinate may appear more than once.
+		std::vector<ChunkCoord> TakeResidencyChanges();
+
+		// Takes copy-on-write snapshots of a chunk and its loaded neighbours.
+		// Must be called from the thread that edits the world; the result can
+		// be read from any thread without locking.
+		ChunkNeighborhood SnapshotNeighborhood(const ChunkCoord& coord) const;
+
+		// Iteration over the loaded chunks.
+		const ChunkMap& GetChunks() const { return chunks_; }
+		size_t GetChunkCount() const { return chunks_.size(); }
+
+	private:
+		// Calls fn(chunk, local_min, local_max) for every chunk overlapping
+		// the world box [min, max). Missing chunks are created if create is
+		// set and skipped otherwise.
+		template <typename Fn>
+		void ForEachChunkInBox(const glm::ivec3& min, const glm::ivec3& max, bool create, Fn fn);
+
+		static size_t GetChunkMemoryUsage(const Chunk& chunk);
+		// Makes a generated chunk resident. Returns false, dropping it, if
+		// the chunk is already there.
+		bool AddChunk(std::unique_ptr<Chunk> chunk);
+
+		long seed_;
+		ChunkMap chunks_;
+		ChunkGenerator generator_;
+		// The built-in terrain, unless a custom generator replaced it.
+		std::shared_ptr<const TerrainGenerator> terrain_;
+		std::unique_ptr<ChunkGenerationPipeline> pipeline_;
+		ChunkResidencyManager residency_;
+		std::unordered_set<ChunkCoord, ChunkCoordHash> dirty_chunks_;
+		std::vector<ChunkCoord> residency_changes_;
 	};
 }
-#endif // WORLD_H
\ No newline at end of file
+#endif // WORLD_H